@@ -0,0 +1,96 @@
+#include "SearchEngine.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr size_t DEFAULT_QUERY_COUNT = 1000;
+
+// fixed seed, so that all engines (and all runs) get the same queries
+constexpr unsigned RANDOM_SEED = 42;
+
+constexpr size_t DAY_SECONDS = 86400;
+
+// random queries between stop names at random times of the day
+std::vector<Query> createQueries(Timetable& timetable, size_t count, size_t maxTrips) {
+    std::vector<std::string_view> names;
+    for (auto&& [_, stop]: timetable.getStops()) names.emplace_back(timetable.getName(stop));
+    std::ranges::sort(names);
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    std::mt19937 random{RANDOM_SEED};
+    std::uniform_int_distribution<size_t> name{0, names.size() - 1};
+    std::uniform_int_distribution<size_t> time{0, DAY_SECONDS - 1};
+
+    std::vector<Query> queries;
+    while (queries.size() < count) {
+        auto&& startName = names[name(random)];
+        auto&& endName = names[name(random)];
+        if (startName == endName) continue;
+        queries.emplace_back(timetable.createQuery(startName, endName, time(random)));
+        queries.back().maxTrips = maxTrips;
+    }
+    return queries;
+}
+
+}
+
+// usage: EngineBenchmark [data directory] [number of queries] [max number of trips]
+int main(int argc, char* argv[]) {
+    std::string directory = argc > 1 ? argv[1] : Timetable::DATA_DIRECTORY;
+    size_t count = argc > 2 ? std::stoul(argv[2]) : DEFAULT_QUERY_COUNT;
+    size_t maxTrips = argc > 3 ? std::stoul(argv[3]) : Query::DEFAULT_MAX_TRIPS;
+
+    std::cout << "Loading data...\n";
+    Timetable timetable;
+    if (!timetable.readCSVData(false, directory)) return 1;
+    timetable.createTransfers();
+    timetable.createConnections();
+    if (!timetable.loadTripTransfers()) {
+        std::cout << "Computing trip transfers...\n";
+        timetable.computeTripTransfers();
+    }
+
+    auto&& queries = createQueries(timetable, count, maxTrips);
+
+    // arrival times of the first engine, the others have to match them
+    std::vector<size_t> arrivalTimes;
+
+    auto fastest = EngineType::Raptor;
+    double fastestTime = 0;
+    for (auto&& type: {EngineType::Raptor, EngineType::TripBased, EngineType::ConnectionScan}) {
+        std::vector<size_t> times;
+        times.reserve(queries.size());
+
+        auto&& begin = std::chrono::steady_clock::now();
+        for (auto&& query: queries) {
+            auto&& engine = createEngine(type, timetable, query);
+            engine->search();
+            times.emplace_back(engine->getJourney().getArrivalTime());
+        }
+        std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - begin;
+
+        if (arrivalTimes.empty()) arrivalTimes = times;
+        size_t found = std::ranges::count_if(times, [](auto&& time) { return time != SIZE_MAX; });
+        size_t mismatches = 0;
+        for (size_t i = 0; i < times.size(); ++i) mismatches += times[i] != arrivalTimes[i];
+
+        double queryTime = duration.count() / static_cast<double>(queries.size());
+        std::cout << std::left << std::setw(12) << getEngineName(type) << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(10) << queryTime << " us/query, found " << found
+                  << ", different results " << mismatches << '\n';
+
+        if (fastestTime == 0 || queryTime < fastestTime) {
+            fastest = type;
+            fastestTime = queryTime;
+        }
+    }
+    std::cout << "Fastest engine: " << getEngineName(fastest) << " (run JourneyPlanner --engine "
+              << getEngineName(fastest) << ")\n";
+}
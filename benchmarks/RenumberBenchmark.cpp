@@ -0,0 +1,172 @@
+#include "Raptor.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+constexpr size_t DEFAULT_QUERY_COUNT = 500;
+
+// fixed seed, so that both layouts (and all runs) get the same queries
+constexpr unsigned RANDOM_SEED = 42;
+
+constexpr size_t DAY_SECONDS = 86400;
+
+// the timed runs are repeated, the fastest one is reported
+constexpr size_t REPETITIONS = 3;
+
+// hardware cache miss counter of this thread, not available in some virtual machines and containers
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = PERF_COUNT_HW_CACHE_MISSES;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        if (fd_ >= 0) ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    ~CacheMissCounter() { if (fd_ >= 0) close(fd_); }
+
+    CacheMissCounter(const CacheMissCounter&) = delete;
+    CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+    [[nodiscard]]
+    bool available() const { return fd_ >= 0; }
+
+    [[nodiscard]]
+    uint64_t read() const {
+        uint64_t value = 0;
+        return ::read(fd_, &value, sizeof(value)) == sizeof(value) ? value : 0;
+    }
+
+private:
+    int fd_ = -1;
+};
+
+// random pairs of stop names and times (the same for both layouts, the names don't change)
+std::vector<std::tuple<std::string, std::string, size_t>> createQueries(Timetable& timetable, size_t count) {
+    std::vector<std::string_view> names;
+    for (auto&& [_, stop]: timetable.getStops()) names.emplace_back(timetable.getName(stop));
+    std::ranges::sort(names);
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    std::mt19937 random{RANDOM_SEED};
+    std::uniform_int_distribution<size_t> name{0, names.size() - 1};
+    std::uniform_int_distribution<size_t> time{0, DAY_SECONDS - 1};
+
+    std::vector<std::tuple<std::string, std::string, size_t>> queries;
+    while (queries.size() < count) {
+        auto&& startName = names[name(random)];
+        auto&& endName = names[name(random)];
+        if (startName != endName) queries.emplace_back(startName, endName, time(random));
+    }
+    return queries;
+}
+
+struct Layout {
+    std::string name;
+    Timetable timetable;
+    std::vector<Query> queries;
+
+    // arrival times of the queries
+    std::vector<size_t> arrivalTimes;
+
+    // the fastest run and the counted cache misses
+    double total = 0;
+    RaptorProfile profile;
+    RaptorProfile misses;
+};
+
+// run all queries of layout, returns the time in microseconds
+double run(Layout& layout, RaptorProfile* profile) {
+    layout.arrivalTimes.clear();
+    auto&& begin = std::chrono::steady_clock::now();
+    for (auto&& query: layout.queries) {
+        Raptor raptor{layout.timetable, query};
+        raptor.setProfile(profile);
+        raptor.raptor();
+        layout.arrivalTimes.emplace_back(raptor.getArrivalTime());
+    }
+    std::chrono::duration<double, std::micro> duration = std::chrono::steady_clock::now() - begin;
+    return duration.count();
+}
+
+}
+
+// compares the raptor search on the stops numbered as in the csv data and renumbered for locality
+// usage: RenumberBenchmark [data directory] [number of queries]
+int main(int argc, char* argv[]) {
+    std::string directory = argc > 1 ? argv[1] : Timetable::DATA_DIRECTORY;
+    size_t count = argc > 2 ? std::stoul(argv[2]) : DEFAULT_QUERY_COUNT;
+
+    std::cout << "Loading data...\n";
+    std::array<Layout, 2> layouts;
+    layouts[0].name = "original";
+    layouts[1].name = "renumbered";
+    for (auto&& layout: layouts) {
+        if (!layout.timetable.readCSVData(false, directory)) return 1;
+        if (&layout == &layouts[1]) layout.timetable.renumber();
+        layout.timetable.createTransfers();
+    }
+
+    for (auto&& [startName, endName, time]: createQueries(layouts[0].timetable, count)) {
+        for (auto&& layout: layouts) layout.queries.emplace_back(layout.timetable.createQuery(startName, endName, time));
+    }
+
+    // warm up, then alternate the layouts, so that both get the same conditions
+    for (auto&& layout: layouts) run(layout, nullptr);
+    for (size_t r = 0; r < REPETITIONS; ++r) {
+        for (auto&& layout: layouts) {
+            RaptorProfile profile;
+            auto&& total = run(layout, &profile);
+            if (r == 0 || total < layout.total) {
+                layout.total = total;
+                layout.profile = profile;
+            }
+        }
+    }
+
+    CacheMissCounter counter;
+    if (counter.available()) {
+        for (auto&& layout: layouts) {
+            layout.misses.readCounter = [&counter] { return counter.read(); };
+            run(layout, &layout.misses);
+        }
+    }
+
+    auto perQuery = [count](double value) { return value / static_cast<double>(count); };
+    auto toMicroseconds = [](std::chrono::nanoseconds time) { return static_cast<double>(time.count()) / 1000; };
+    std::cout << std::fixed << std::setprecision(1) << "layout        us/query   scanRoutes   scanTransfers"
+              << (counter.available() ? "   misses/query (routes, transfers)\n" : "\n");
+    for (auto&& layout: layouts) {
+        std::cout << std::left << std::setw(12) << layout.name << std::right << std::setw(10)
+                  << perQuery(layout.total) << std::setw(13) << perQuery(toMicroseconds(layout.profile.routes))
+                  << std::setw(16) << perQuery(toMicroseconds(layout.profile.transfers));
+        if (counter.available()) {
+            std::cout << std::setw(12) << perQuery(static_cast<double>(layout.misses.routesCounter)) << ", "
+                      << perQuery(static_cast<double>(layout.misses.transfersCounter));
+        }
+        std::cout << '\n';
+    }
+    if (!counter.available()) std::cout << "cache misses not measured, perf events are not available\n";
+
+    size_t different = 0;
+    for (size_t i = 0; i < count; ++i) different += layouts[0].arrivalTimes[i] != layouts[1].arrivalTimes[i];
+    std::cout << "different results " << different << '\n';
+}
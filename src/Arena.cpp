@@ -0,0 +1,94 @@
+#include "Arena.hpp"
+
+#include <sys/mman.h>
+
+#include <cstdint>
+
+namespace {
+
+size_t alignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+}
+
+std::optional<HugePages> getHugePages(std::string_view name) {
+    if (name == "none") return HugePages::None;
+    if (name == "transparent") return HugePages::Transparent;
+    if (name == "explicit") return HugePages::Explicit;
+    return std::nullopt;
+}
+
+std::string_view getHugePagesName(HugePages hugePages) {
+    switch (hugePages) {
+        case HugePages::None: return "none";
+        case HugePages::Transparent: return "transparent";
+        case HugePages::Explicit: return "explicit";
+    }
+    return "";
+}
+
+Arena::~Arena() {
+    release();
+}
+
+bool Arena::reserve(size_t size, HugePages hugePages) {
+    release();
+    if (size == 0) return true;
+
+    size = alignUp(size, hugePages == HugePages::None ? 1 << 12 : HUGE_PAGE_SIZE);
+    void* p = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    // fails if there aren't enough huge pages reserved (vm.nr_hugepages)
+    if (hugePages == HugePages::Explicit) {
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) {
+            mapping_ = data_ = static_cast<char*>(p);
+            mappingSize_ = size_ = size;
+            hugePages_ = HugePages::Explicit;
+            return true;
+        }
+    }
+#endif
+    if (hugePages == HugePages::Explicit) hugePages = HugePages::Transparent;
+
+    // transparent huge pages are used only for whole huge pages, the block is aligned to them
+    auto&& padding = hugePages == HugePages::Transparent ? HUGE_PAGE_SIZE : 0;
+    p = mmap(nullptr, size + padding, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return false;
+    mapping_ = static_cast<char*>(p);
+    mappingSize_ = size + padding;
+    data_ = mapping_ + (alignUp(reinterpret_cast<uintptr_t>(mapping_), padding == 0 ? 1 : padding) -
+        reinterpret_cast<uintptr_t>(mapping_));
+    size_ = size;
+#ifdef MADV_HUGEPAGE
+    if (hugePages == HugePages::Transparent && madvise(data_, size_, MADV_HUGEPAGE) != 0) hugePages = HugePages::None;
+#else
+    hugePages = HugePages::None;
+#endif
+    hugePages_ = hugePages;
+    return true;
+}
+
+void Arena::release() {
+    if (mapping_ != nullptr) munmap(mapping_, mappingSize_);
+    mapping_ = data_ = nullptr;
+    mappingSize_ = size_ = used_ = 0;
+    hugePages_ = HugePages::None;
+}
+
+void* Arena::do_allocate(size_t bytes, size_t alignment) {
+    auto&& begin = alignUp(used_, alignment);
+    if (data_ == nullptr || begin + bytes > size_) {
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+    used_ = begin + bytes;
+    return data_ + begin;
+}
+
+void Arena::do_deallocate(void* p, size_t bytes, size_t alignment) {
+    // memory of the block is reused only by the next reserve
+    auto&& address = static_cast<char*>(p);
+    if (address >= data_ && address < data_ + size_) return;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+}
@@ -0,0 +1,74 @@
+#ifndef ARENA_HPP_
+#define ARENA_HPP_
+
+#include <cstddef>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+
+// pages backing the memory of an arena
+enum class HugePages {
+    // normal pages
+    None,
+
+    // transparent huge pages (madvise), the kernel may still use normal pages
+    Transparent,
+
+    // reserved huge pages (MAP_HUGETLB), transparent ones if none are available
+    Explicit
+};
+
+// huge pages by name (none, transparent, explicit)
+std::optional<HugePages> getHugePages(std::string_view name);
+
+std::string_view getHugePagesName(HugePages hugePages);
+
+// one block of memory for the arrays of the timetable, allocated by moving a pointer and never freed
+// till the arena is destroyed, the arrays next to each other need fewer pages (and TLB entries),
+// with huge pages even less, allocations that don't fit into the block go to the heap
+class Arena : public std::pmr::memory_resource {
+public:
+    Arena() = default;
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // map a new block for size bytes, returns false if it can't be mapped,
+    // the memory allocated from the previous block must not be used anymore
+    bool reserve(size_t size, HugePages hugePages);
+
+    // mapped bytes
+    [[nodiscard]]
+    size_t getSize() const { return size_; }
+
+    // allocated bytes
+    [[nodiscard]]
+    size_t getUsed() const { return used_; }
+
+    // pages really used (explicit huge pages fall back to transparent ones)
+    [[nodiscard]]
+    HugePages getHugePages() const { return hugePages_; }
+
+    static constexpr size_t HUGE_PAGE_SIZE = 2 << 20;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+    [[nodiscard]]
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void release();
+
+    char* data_ = nullptr;
+    size_t size_ = 0;
+    size_t used_ = 0;
+
+    // mapped bytes including the alignment to huge pages
+    char* mapping_ = nullptr;
+    size_t mappingSize_ = 0;
+
+    HugePages hugePages_ = HugePages::None;
+};
+
+#endif
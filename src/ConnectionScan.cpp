@@ -0,0 +1,134 @@
+#include "ConnectionScan.hpp"
+
+void ConnectionScan::initialization() {
+    auto&& connections = *connections_;
+    auto&& stopCount = connections.getStopCount();
+
+    labels_.assign(stopCount * (numberOfTrips_ + 1), SIZE_MAX);
+    parents_.resize(labels_.size());
+    tripTrips_.assign(connections.getTripCount(), 0);
+    boardings_.resize(connections.getTripCount());
+    egressOffsets_.assign(stopCount, SIZE_MAX);
+
+    arrivalTime_ = SIZE_MAX;
+    minEgressOffset_ = SIZE_MAX;
+    targetTrips_ = 0;
+
+    for (auto&& [stop, offset]: query_.egress) {
+        auto&& egressOffset = egressOffsets_[stop->getId()];
+        egressOffset = std::min(egressOffset, offset);
+        minEgressOffset_ = std::min(minEgressOffset_, offset);
+    }
+
+    // stops reachable from the source, the journey starts there
+    for (auto&& [stop, offset]: query_.access) {
+        auto&& label = getLabel(static_cast<uint32_t>(stop->getId()), 0);
+        if (startTime_ + offset < labels_[label]) {
+            labels_[label] = startTime_ + offset;
+            parents_[label] = {};
+        }
+    }
+}
+
+bool ConnectionScan::improve(uint32_t stop, size_t k, size_t time, const ParentRecord& parent) {
+    if (time >= labels_[getLabel(stop, k)]) return false;
+
+    // the arrival is valid for all journeys with more trips as well
+    for (size_t j = k; j <= numberOfTrips_ && time < labels_[getLabel(stop, j)]; ++j) {
+        labels_[getLabel(stop, j)] = time;
+        parents_[getLabel(stop, j)] = parent;
+    }
+
+    // the same arrival at the target with fewer trips is preferred
+    if (auto&& offset = egressOffsets_[stop]; offset != SIZE_MAX) {
+        if (time + offset < arrivalTime_ || (time + offset == arrivalTime_ && k < targetTrips_)) {
+            arrivalTime_ = time + offset;
+            targetStop_ = stop;
+            targetTrips_ = k;
+        }
+    }
+    return true;
+}
+
+void ConnectionScan::search() {
+    initialization();
+    startLimits();
+    if (query_.access.empty() || minEgressOffset_ == SIZE_MAX) return;
+
+    auto&& connections = *connections_;
+    auto&& all = connections.getConnections();
+
+    // skip the connections departing before the start
+    size_t minAccessOffset = std::ranges::min(query_.access, {}, &StopOffset::offset).offset;
+    for (size_t c = connections.getFirstConnection(startTime_ + minAccessOffset); c < all.size(); ++c) {
+        auto&& connection = all[c];
+
+        // connections are scanned by departure time, the labels are valid till the last scanned one
+        if (stopSearch()) break;
+
+        // every later connection arrives at the target later
+        if (connection.departureTime + minEgressOffset_ > arrivalTime_) break;
+
+        // board the trip with fewer trips than before (if possible)
+        auto&& trips = tripTrips_[connection.trip];
+        size_t maxTrips = trips != 0 ? trips - 1 : numberOfTrips_;
+        for (size_t k = 1; k <= maxTrips; ++k) {
+            auto&& time = labels_[getLabel(connection.from, k - 1)];
+
+            // don't add CHANGE_TIME at the access stops
+            if (time != SIZE_MAX && time + (k > 1 ? CHANGE_TIME : 0) <= connection.departureTime) {
+                trips = static_cast<uint8_t>(k);
+                boardings_[connection.trip] = {connection.from, connection.index};
+                break;
+            }
+        }
+        if (trips == 0) continue;
+
+        // stay on the trip till the next stop
+        auto&& [boardingStop, boardingIndex] = boardings_[connection.trip];
+        ParentRecord parent{connections.getTrip(connection.trip), connections.getStop(boardingStop), boardingIndex,
+                            connection.index + 1};
+        if (!improve(connection.to, trips, connection.arrivalTime, parent)) continue;
+
+        // walk to the stops around
+        for (auto&& to: connections.getFootpaths(connection.to)) {
+            improve(to, trips, connection.arrivalTime + TRANSFER_TIME, {nullptr, connections.getStop(connection.to)});
+        }
+    }
+}
+
+Journey ConnectionScan::getJourney() const {
+    Journey journey;
+    journey.setComplete(!isInterrupted());
+    if (arrivalTime_ == SIZE_MAX) return journey;
+    journey.setArrivalTime(arrivalTime_);
+
+    // follow the parent records from the destination back to the source,
+    // the stops reachable from the source have no parent
+    auto&& connections = *connections_;
+    size_t k = targetTrips_;
+    for (Stop* stop = connections.getStop(targetStop_); stop != nullptr;) {
+        auto&& id = static_cast<uint32_t>(stop->getId());
+        auto&& parent = parents_[getLabel(id, k)];
+        if (parent.trip != nullptr) {
+            auto&& leg = createLeg(parent.trip, parent.fromIndex, parent.toIndex);
+            journey.addLeg(leg);
+
+            // the boarding stop was reached with fewer trips (or it's an access stop),
+            // find the lowest number of trips that catches the trip there
+            auto&& from = static_cast<uint32_t>(parent.from->getId());
+            size_t departureTime = leg.getDepartureTime();
+            size_t trips = 0;
+            for (; trips + 1 < k; ++trips) {
+                auto&& time = labels_[getLabel(from, trips)];
+                if (time != SIZE_MAX && time + (trips > 0 ? CHANGE_TIME : 0) <= departureTime) break;
+            }
+            k = trips;
+        }
+        stop = parent.from;
+    }
+
+    // legs are filled from end to start, reverse the order
+    journey.reverse();
+    return journey;
+}
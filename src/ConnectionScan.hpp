@@ -0,0 +1,88 @@
+#ifndef CONNECTIONSCAN_HPP_
+#define CONNECTIONSCAN_HPP_
+
+#include "SearchEngine.hpp"
+
+#include <algorithm>
+
+// earliest arrival search scanning the time sorted connections
+// (Timetable::createConnections must be called first)
+// the number of trips is bounded by query.maxTrips and the results are the same as the results
+// of the raptor algorithm
+class ConnectionScan : public SearchEngine {
+public:
+    ConnectionScan(Timetable& t, const Query& query) : ConnectionScan(t, query, t.getConnections()) {}
+
+    // run the Connection Scan Algorithm
+    void search() override;
+
+    // get the resulting connection - sequence of trips with boarding and exit stops
+    [[nodiscard]]
+    Journey getJourney() const override;
+
+private:
+    // search connections (with their schedule) for the whole run
+    ConnectionScan(Timetable& t, const Query& query, std::shared_ptr<const Connections> connections)
+        : SearchEngine(t, query, connections->getSchedule()), connections_(std::move(connections)),
+          numberOfTrips_(std::clamp<size_t>(query.maxTrips, 1, Journey::MAX_LEGS)),
+          startTime_(query.startTime) {}
+
+    // stop where a trip was boarded
+    struct Boarding {
+        uint32_t stop;
+        uint32_t index;
+    };
+
+    // initialize values for the search
+    void initialization();
+
+    // arrive at stop with k trips at time, update the labels and the target
+    // returns false if the arrival isn't better than the known ones
+    bool improve(uint32_t stop, size_t k, size_t time, const ParentRecord& parent);
+
+    // index of the label of stop using at most k trips,
+    // labels are stop-major (all labels of a stop are together, they are updated together)
+    [[nodiscard]]
+    size_t getLabel(uint32_t stop, size_t k) const { return stop * (numberOfTrips_ + 1) + k; }
+
+    // change trip at the exact same stop, same as in the raptor algorithm
+    static constexpr size_t CHANGE_TIME = 30;
+
+    // transfer/walk to another stop, same as in the raptor algorithm
+    static constexpr size_t TRANSFER_TIME = 120;
+
+    // connections of the timetable when the engine was created (with the times of their schedule)
+    const std::shared_ptr<const Connections> connections_;
+
+    // max number of trips used in the search
+    const size_t numberOfTrips_;
+
+    const size_t startTime_;
+
+    // the earliest arrival time at stop using at most k trips (k = 0 only at the access stops)
+    std::vector<size_t> labels_;
+
+    // how the stops were reached, valid only where labels_ are set
+    std::vector<ParentRecord> parents_;
+
+    // trip id -> the lowest number of trips (including the trip) with which the trip was boarded, 0 if not boarded
+    std::vector<uint8_t> tripTrips_;
+
+    // trip id -> where the trip was boarded with tripTrips_ trips
+    std::vector<Boarding> boardings_;
+
+    // stop id -> offset of the egress stop, SIZE_MAX for other stops
+    std::vector<size_t> egressOffsets_;
+
+    // the lowest offset of the egress stops (lower bound for the early exit)
+    size_t minEgressOffset_ = SIZE_MAX;
+
+    // the earliest arrival time at the target
+    size_t arrivalTime_ = SIZE_MAX;
+
+    // stop from which the target was reached at arrivalTime_ and the number of trips
+    uint32_t targetStop_ = 0;
+    size_t targetTrips_ = 0;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "Connections.hpp"
+#include "Timetable.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+void Connections::create(Timetable& timetable) {
+    schedule_ = timetable.getSchedule();
+    size_t tripCount = 0;
+    for (auto&& [id, _]: timetable.getTrips()) tripCount = std::max(tripCount, id + 1);
+
+    trips_.assign(tripCount, nullptr);
+    stops_.assign(timetable.getStopCount(), nullptr);
+    for (auto&& [id, trip]: timetable.getTrips()) trips_[id] = &trip;
+    for (auto&& [_, stop]: timetable.getStops()) stops_[stop.getId()] = &stop;
+
+    connections_.clear();
+    for (auto&& trip: trips_) {
+        if (trip == nullptr) continue;
+        auto&& stops = trip->getRoute()->getStops();
+        auto&& times = schedule_->getTimes(*trip);
+        for (size_t i = 0; i + 1 < stops.size(); ++i) {
+            connections_.push_back({static_cast<uint32_t>(times.getDepartureTime(i)),
+                                    static_cast<uint32_t>(times.getArrivalTime(i + 1)),
+                                    static_cast<uint32_t>(stops[i]->getId()),
+                                    static_cast<uint32_t>(stops[i + 1]->getId()),
+                                    static_cast<uint32_t>(trip->getId()), static_cast<uint32_t>(i)});
+        }
+    }
+
+    // connections of a trip departing at the same time (zero travel time) stay in the trip order
+    std::ranges::sort(connections_, {}, [](auto&& c) {
+        return std::tie(c.departureTime, c.arrivalTime, c.trip, c.index);
+    });
+    connections_.shrink_to_fit();
+
+    // walking transfers of every stop
+    footpathOffsets_.assign(stops_.size() + 1, 0);
+    footpaths_.clear();
+    auto&& transfers = timetable.getTransfers();
+    for (size_t id = 0; id < stops_.size(); ++id) {
+        if (stops_[id] != nullptr) {
+            if (auto&& it = transfers.find(stops_[id]); it != transfers.end()) {
+                for (auto&& to: it->second) footpaths_.emplace_back(static_cast<uint32_t>(to->getId()));
+            }
+        }
+        footpathOffsets_[id + 1] = static_cast<uint32_t>(footpaths_.size());
+    }
+}
+
+size_t Connections::getFirstConnection(size_t time) const {
+    auto&& it = std::ranges::lower_bound(connections_, time, {}, &Connection::departureTime);
+    return static_cast<size_t>(it - connections_.begin());
+}
+
+size_t Connections::getMemoryUsage() const {
+    return connections_.capacity() * sizeof(Connection) + trips_.capacity() * sizeof(Trip*) +
+        stops_.capacity() * sizeof(Stop*) + footpathOffsets_.capacity() * sizeof(uint32_t) +
+        footpaths_.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,90 @@
+#ifndef CONNECTIONS_HPP_
+#define CONNECTIONS_HPP_
+
+#include "DataTypes.hpp"
+#include "Schedule.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+class Timetable;
+
+// elementary connection - trip going from one stop to the next one
+struct Connection {
+    uint32_t departureTime;
+    uint32_t arrivalTime;
+
+    // ids of the departure and arrival stops
+    uint32_t from;
+    uint32_t to;
+
+    uint32_t trip;
+
+    // index of the departure stop along the route of the trip
+    uint32_t index;
+};
+
+// all elementary connections of the timetable in one array sorted by the departure time,
+// used by the Connection Scan Algorithm (Dibbelt et al., Intriguingly Simple and Fast Transit Routing, 2013)
+class Connections {
+public:
+    // create the connections from the stop times of all trips in the current schedule of timetable
+    void create(Timetable& timetable);
+
+    [[nodiscard]]
+    bool empty() const { return connections_.empty(); }
+
+    [[nodiscard]]
+    std::span<const Connection> getConnections() const { return connections_; }
+
+    // index of the first connection departing at time or later
+    [[nodiscard]]
+    size_t getFirstConnection(size_t time) const;
+
+    [[nodiscard]]
+    Trip* getTrip(uint32_t id) const { return trips_[id]; }
+
+    [[nodiscard]]
+    Stop* getStop(uint32_t id) const { return stops_[id]; }
+
+    // get ids of the stops in walking distance from stop
+    [[nodiscard]]
+    std::span<const uint32_t> getFootpaths(uint32_t stop) const {
+        return {footpaths_.data() + footpathOffsets_[stop], footpaths_.data() + footpathOffsets_[stop + 1]};
+    }
+
+    [[nodiscard]]
+    size_t getTripCount() const { return trips_.size(); }
+
+    [[nodiscard]]
+    size_t getStopCount() const { return stops_.size(); }
+
+    // schedule from which the connections were created
+    [[nodiscard]]
+    const std::shared_ptr<const Schedule>& getSchedule() const { return schedule_; }
+
+    // bytes used by the connections and the indices
+    [[nodiscard]]
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<Connection> connections_;
+
+    std::shared_ptr<const Schedule> schedule_;
+
+    // trip id -> trip
+    std::vector<Trip*> trips_;
+
+    // stop id -> stop
+    std::vector<Stop*> stops_;
+
+    // stop id -> index of its first footpath
+    std::vector<uint32_t> footpathOffsets_;
+
+    // footpaths of all stops
+    std::vector<uint32_t> footpaths_;
+};
+
+#endif
@@ -1,86 +1,95 @@
 #ifndef DATATYPES_HPP_
 #define DATATYPES_HPP_
 
-#include <string>
+#include "StringPool.hpp"
+
 #include <vector>
-#include <unordered_map>
+#include <memory_resource>
+#include <algorithm>
+#include <cstdint>
 
 class Route;
 class Stop;
 class Trip;
 
+// how a stop was reached in one iteration of the raptor algorithm
+// used for the connection reconstruction
+struct ParentRecord {
+    // trip that arrived at the stop, nullptr if the stop was reached by a transfer
+    Trip* trip = nullptr;
+
+    // boarding stop of the trip or the stop from which we transferred
+    Stop* from = nullptr;
+
+    // indices of the boarding stop and this stop along the route of the trip
+    uint32_t fromIndex = 0;
+    uint32_t toIndex = 0;
+};
+
 class Stop {
 public:
-    Stop(size_t id, std::string name, bool artificial=false) :
-        id_(id), name_(std::move(name)), artificial_(artificial) {}
+    Stop(size_t id, StringId name) :
+        id_(id), originalId_(id), name_(name) {}
 
 	bool operator==(const Stop& other) const { return id_ == other.id_; }
 
-	void mark() { marked_ = true; }
-
-	void unmark() { marked_ = false; }
-
-	[[nodiscard]]
-    bool isMarked() const { return marked_; }
+	std::pmr::vector<Route*>& getRoutes() { return routes_; }
 
     [[nodiscard]]
-    bool isArtificial() const { return artificial_; }
-
-    std::vector<size_t>& getArrTimesKTrips() { return arrTimesKTrips_; }
-
-	size_t& getEarliestTime() { return earliestArrTime_; }
-
-	std::vector<Route*>& getRoutes() { return routes_; }
+    const std::pmr::vector<Route*>& getRoutes() const { return routes_; }
 
+    // id used to index per stop arrays (the original id unless renumbered by Timetable::renumber)
     [[nodiscard]]
     size_t getId() const { return id_; }
 
-    [[nodiscard]]
-    const std::string& getName() const { return name_; }
-
-    [[maybe_unused]]
-    Trip*& getEarliestTrip() { return earliestTrip_; }
+    void setId(size_t id) { id_ = id; }
 
-    Stop*& getTransferFrom() { return transferFrom_; }
+    // id from the csv data
+    [[nodiscard]]
+    size_t getOriginalId() const { return originalId_; }
 
-    std::unordered_map<size_t, Trip*>& getEarliestTrips() { return earliestTrips_; }
+    // id of the name in the string pool of the timetable
+    [[nodiscard]]
+    StringId getNameId() const { return name_; }
 
 private:
 
-    const size_t id_;
-    const std::string name_;
-
-    // mark for raptor algorithm
-	bool marked_ = false;
-
-    const bool artificial_;
+    size_t id_;
+    const size_t originalId_;
+    const StringId name_;
 
-    // all routes that use this stop
-    std::vector<Route*> routes_;
+    // all routes that use this stop (in the arena of the timetable after Timetable::compact)
+    std::pmr::vector<Route*> routes_;
+};
 
-    // k-th value represents the earliest arrival time at this stop
-    // in the k-th iteration (using at most k trips)
-    std::vector<size_t> arrTimesKTrips_;
+// stop times of a trip, every route keeps the times of its trips in one array (in the order of the trips),
+// so the searches find the trip to board without reading the trips themselves
+// (the delayed times are in the current schedule of the timetable, see Schedule)
+struct TripTimes {
+    // all stop times are relative to this time (the earliest time of the trip)
+    uint32_t baseTime = 0;
 
-    // the earliest arrival time at this stop (overall)
-	size_t earliestArrTime_ = SIZE_MAX;
+    // sequence of arrival time offsets at the stops of the trip
+    // (points into the stop times of the route, can be shared with other trips)
+    const uint32_t* arrivalOffsets = nullptr;
 
-    // the earliest trip that arrives at this stop
-    Trip* earliestTrip_ = nullptr;
+    // sequence of departure time offsets at the stops of the trip,
+    // same as arrivalOffsets if the trip doesn't wait at any stop
+    const uint32_t* departureOffsets = nullptr;
 
-    // stop with the earliest arrival time,
-    // from which we transferred to this stop
-    Stop* transferFrom_ = nullptr;
+    // arrival time at the i-th stop of the trip
+    [[nodiscard]]
+    size_t getArrivalTime(size_t i) const { return baseTime + arrivalOffsets[i]; }
 
-    // map of iteration -> the earliest trip
-    // used for the connection reconstruction
-    std::unordered_map<size_t , Trip*> earliestTrips_;
+    // departure time from the i-th stop of the trip
+    [[nodiscard]]
+    size_t getDepartureTime(size_t i) const { return baseTime + departureOffsets[i]; }
 };
 
 class Route {
 public:
-    Route(size_t id, std::string name, size_t type) :
-        id_(id), name_(std::move(name)), type_(type) {}
+    Route(size_t id, StringId name, size_t type) :
+        id_(id), originalId_(id), name_(name), type_(type) {}
 
 	// true if stop s1 is before stop s2 on this route
 	[[nodiscard]]
@@ -90,83 +99,168 @@ public:
 	[[nodiscard]]
     size_t getStopIndex(const Stop* s) const;
 
-	std::vector<Stop*>& getStops() { return stops_; }
+	std::pmr::vector<Stop*>& getStops() { return stops_; }
+
+    [[nodiscard]]
+    const std::pmr::vector<Stop*>& getStops() const { return stops_; }
+
+	std::pmr::vector<Trip*>& getTrips() { return trips_; }
+
+    [[nodiscard]]
+    const std::pmr::vector<Trip*>& getTrips() const { return trips_; }
+
+    // times of the trips in the order of the trips
+    std::pmr::vector<TripTimes>& getTripTimes() { return tripTimes_; }
+
+    [[nodiscard]]
+    const std::pmr::vector<TripTimes>& getTripTimes() const { return tripTimes_; }
+
+    // create the times of the trips again in the order of the trips (after the trips were changed),
+    // every trip points to its times
+    void updateTripTimes();
 
-	std::vector<Trip*>& getTrips() { return trips_; }
+    // index of trip in the trips of this route
+    [[nodiscard]]
+    size_t getTripIndex(const Trip& trip) const;
+
+    // time offsets of the trips of this route, every sequence has one value per stop
+    std::pmr::vector<uint32_t>& getStopTimes() { return stopTimes_; }
+
+    [[nodiscard]]
+    const std::pmr::vector<uint32_t>& getStopTimes() const { return stopTimes_; }
 
     [[maybe_unused]] [[nodiscard]]
     size_t getType() const { return type_; }
 
+    // the original id unless renumbered by Timetable::renumber
 	[[nodiscard]]
     size_t getId() const { return id_; }
 
+    void setId(size_t id) { id_ = id; }
+
+    // id from the csv data
+    [[nodiscard]]
+    size_t getOriginalId() const { return originalId_; }
+
+    // id of the name in the string pool of the timetable
     [[nodiscard]]
-    const std::string& getName() const { return name_; }
+    StringId getNameId() const { return name_; }
 
 private:
 
-	const size_t id_;
-	const std::string name_;
+	size_t id_;
+	const size_t originalId_;
+	const StringId name_;
 	const size_t type_;
 
+    // the vectors are in the arena of the timetable after Timetable::compact
+
     // sequence of stops on this route sorted from start to finish
-	std::vector<Stop*> stops_;
+	std::pmr::vector<Stop*> stops_;
 
     // ascending sequence of trips operating on this route,
-    // sorted by departure time
-	std::vector<Trip*> trips_;
+    // sorted by the scheduled departure time
+	std::pmr::vector<Trip*> trips_;
+
+    // times of trips_[t] are tripTimes_[t]
+    std::pmr::vector<TripTimes> tripTimes_;
+
+    // arrival/departure time offsets of all trips (see Trip::setStopTimes),
+    // trips running the same pattern shifted in time may share them
+    std::pmr::vector<uint32_t> stopTimes_;
 };
 
 class Trip {
 public:
-    Trip(size_t id, Route* route, std::string headsign, size_t direction) :
-        id_(id), headsign_(std::move(headsign)),
+    Trip(size_t id, Route* route, StringId headsign, size_t direction) :
+        id_(id), headsign_(headsign),
         direction_(direction), route_(route) {}
 
     // get the index of s for route, on which operates this trip
     [[maybe_unused]] [[nodiscard]]
     size_t getStopIndex(const Stop* s) const { return route_->getStopIndex(s); }
 
-    // add arrival and departure time for the actual stop of this trip
-    void addTimes(size_t arr, size_t dep) {
-        arrivalTimes_.push_back(arr); departureTimes_.push_back(dep);
+    // set the stop times of this trip - offsets (from baseTime) pointing into the stop times of the route,
+    // the trip has to have its times in the route (see Route::updateTripTimes)
+    void setStopTimes(uint32_t baseTime, const uint32_t* arrivalOffsets, const uint32_t* departureOffsets) {
+        times_->baseTime = baseTime;
+        times_->arrivalOffsets = arrivalOffsets;
+        times_->departureOffsets = departureOffsets;
+    }
+
+    // point the stop times into a copy of the stop times of the route (from at oldData to newData)
+    void moveStopTimes(const uint32_t* oldData, const uint32_t* newData) {
+        times_->arrivalOffsets = newData + (times_->arrivalOffsets - oldData);
+        times_->departureOffsets = newData + (times_->departureOffsets - oldData);
+    }
+
+    // delay all stop times of this trip by delay seconds from the schedule (negative if it's ahead),
+    // the times are changed in the next schedule of the timetable (see Timetable::applyDelays)
+    void setDelay(int32_t delay) { delay_ = delay; }
+
+    [[nodiscard]]
+    int32_t getDelay() const { return delay_; }
+
+    // the earliest time of the trip with the delay
+    [[nodiscard]]
+    uint32_t getDelayedBaseTime() const {
+        return static_cast<uint32_t>(std::max<int64_t>(static_cast<int64_t>(times_->baseTime) + delay_, 0));
     }
 
+    // scheduled arrival time at the i-th stop of this trip (without the delay)
+    [[nodiscard]]
+    size_t getArrivalTime(size_t i) const { return times_->getArrivalTime(i); }
+
+    // scheduled departure time from the i-th stop of this trip (without the delay)
+    [[nodiscard]]
+    size_t getDepartureTime(size_t i) const { return times_->getDepartureTime(i); }
+
     [[nodiscard]]
     size_t getId() const { return id_; }
 
     Route* getRoute() { return route_; }
 
-    [[maybe_unused]] [[nodiscard]]
-    const std::string& getHeadsign() const { return headsign_; }
+    [[nodiscard]]
+    const Route* getRoute() const { return route_; }
 
-    [[maybe_unused]] [[nodiscard]]
-    size_t getDirection() const { return direction_; }
+    // the earliest time of the trip by the schedule
+    [[nodiscard]]
+    uint32_t getScheduledBaseTime() const { return times_->baseTime; }
 
+    // arrival time offsets at the stops of this trip (from the scheduled base time)
     [[nodiscard]]
-    const std::vector<size_t>& getArrivalTimes() const { return arrivalTimes_; }
+    const uint32_t* getArrivalOffsets() const { return times_->arrivalOffsets; }
 
+    // departure time offsets from the stops of this trip (from the scheduled base time)
     [[nodiscard]]
-    const std::vector<size_t>& getDepartureTimes() const { return departureTimes_; }
+    const uint32_t* getDepartureOffsets() const { return times_->departureOffsets; }
 
-    Stop*& getBoardingStop() { return boardingStop_; }
+    // scheduled times of this trip in the trip times of its route, nullptr before they are created
+    [[nodiscard]]
+    const TripTimes* getTimes() const { return times_; }
+
+    void setTimes(TripTimes* times) { times_ = times; }
+
+    // id of the headsign in the string pool of the timetable
+    [[nodiscard]]
+    StringId getHeadsignId() const { return headsign_; }
+
+    [[maybe_unused]] [[nodiscard]]
+    size_t getDirection() const { return direction_; }
 
 private:
 	const size_t id_;
-    const std::string headsign_;
+    const StringId headsign_;
     const size_t direction_;
 
     // a route on which operates this trip
-    Route* const route_;
-
-    // stop at which this trip was boarded
-    Stop* boardingStop_ = nullptr;
+    Route* route_;
 
-    // sequence of arrival times at the stops of this trip
-    std::vector<size_t> arrivalTimes_;
+    // scheduled base time and offsets of the stop times (in the trip times of the route)
+    TripTimes* times_ = nullptr;
 
-    // sequence of departure times at the stops of this trip
-    std::vector<size_t> departureTimes_;
+    // current delay in seconds
+    int32_t delay_ = 0;
 };
 
 #endif
\ No newline at end of file
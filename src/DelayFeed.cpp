@@ -0,0 +1,34 @@
+#include "DelayFeed.hpp"
+#include "Parsing.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <string_view>
+
+bool DelayFeed::read(const std::string& filename) {
+    std::ifstream in{filename};
+    if (!in.good() || !in.is_open()) {
+        std::cout << "Can't read " << filename << '\n';
+        return false;
+    }
+    std::string line;
+    std::getline(in, line); // skip the first line - column names
+
+    delays_.clear();
+    skippedRows_ = 0;
+    while (std::getline(in, line)) {
+        std::string_view row{line};
+        if (row.ends_with('\r')) row.remove_suffix(1);
+        if (row.empty()) continue;
+        // malformed rows are skipped, the rest of the feed is still applied
+        auto&& comma = row.find(',');
+        auto&& trip = parseNumber<size_t>(row.substr(0, comma));
+        auto&& delay = comma == std::string_view::npos ? std::nullopt : parseNumber<int32_t>(row.substr(comma + 1));
+        if (!trip || !delay) {
+            ++skippedRows_;
+            continue;
+        }
+        delays_.push_back({*trip, *delay});
+    }
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifndef DELAYFEED_HPP_
+#define DELAYFEED_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// current delay of a trip in seconds (negative if the trip is ahead of schedule)
+struct TripDelay {
+    size_t trip;
+    int32_t delay;
+};
+
+// real-time delays of trips read from a csv file (trip_index,delay),
+// a simple stand-in for the trip updates of a GTFS-realtime feed
+class DelayFeed {
+public:
+    // read all delays from the file, returns false if it can't be read
+    bool read(const std::string& filename);
+
+    [[nodiscard]]
+    const std::vector<TripDelay>& getDelays() const { return delays_; }
+
+    // rows left out because they aren't trip_index,delay numbers
+    [[nodiscard]]
+    size_t getSkippedRowCount() const { return skippedRows_; }
+
+private:
+    std::vector<TripDelay> delays_;
+    size_t skippedRows_ = 0;
+};
+
+#endif
@@ -0,0 +1,78 @@
+#include "Departures.hpp"
+#include "Timetable.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+void Departures::create(Timetable& timetable) {
+    schedule_ = timetable.getSchedule();
+    size_t tripCount = 0;
+    for (auto&& [id, _]: timetable.getTrips()) tripCount = std::max(tripCount, id + 1);
+    trips_.assign(tripCount, nullptr);
+    for (auto&& [id, trip]: timetable.getTrips()) trips_[id] = &trip;
+    stops_.assign(timetable.getStopCount(), nullptr);
+    for (auto&& [_, stop]: timetable.getStops()) stops_[stop.getId()] = &stop;
+
+    // count the departures of every stop (no departure from the last stop of a trip)
+    offsets_.assign(timetable.getStopCount() + 1, 0);
+    for (auto&& trip: trips_) {
+        if (trip == nullptr) continue;
+        auto&& stops = trip->getRoute()->getStops();
+        for (size_t i = 0; i + 1 < stops.size(); ++i) ++offsets_[stops[i]->getId() + 1];
+    }
+    for (size_t id = 0; id + 1 < offsets_.size(); ++id) offsets_[id + 1] += offsets_[id];
+
+    // fill the departures of every stop
+    departures_.resize(offsets_.back());
+    auto next = offsets_;
+    for (auto&& trip: trips_) {
+        if (trip == nullptr) continue;
+        auto&& stops = trip->getRoute()->getStops();
+        auto&& times = schedule_->getTimes(*trip);
+        for (size_t i = 0; i + 1 < stops.size(); ++i) {
+            auto&& stop = stops[i]->getId();
+            departures_[next[stop]++] = {static_cast<uint32_t>(times.getDepartureTime(i)),
+                                         static_cast<uint32_t>(trip->getId()), static_cast<uint32_t>(stop),
+                                         static_cast<uint32_t>(i)};
+        }
+    }
+
+    for (size_t id = 0; id + 1 < offsets_.size(); ++id) {
+        std::sort(departures_.begin() + offsets_[id], departures_.begin() + offsets_[id + 1],
+                  [](auto&& d1, auto&& d2) { return std::tie(d1.time, d1.trip) < std::tie(d2.time, d2.trip); });
+    }
+}
+
+std::span<const Departure> Departures::getNextDepartures(const Stop& stop, size_t time, size_t count) const {
+    auto&& departures = getDepartures(stop);
+    auto&& first = std::ranges::lower_bound(departures, time, {}, &Departure::time);
+    auto&& last = departures.end() - first > static_cast<ptrdiff_t>(count) ? first + count : departures.end();
+    return {first, last};
+}
+
+std::vector<Departure> Departures::getNextDepartures(std::span<Stop* const> stops, size_t time,
+                                                     size_t count) const {
+    // merge the next departures of all stops (there are just a few stops with the same name)
+    std::vector<std::span<const Departure>> next;
+    for (auto&& stop: stops) {
+        if (auto&& departures = getNextDepartures(*stop, time, count); !departures.empty()) {
+            next.emplace_back(departures);
+        }
+    }
+
+    std::vector<Departure> result;
+    while (result.size() < count && !next.empty()) {
+        auto&& earliest = std::ranges::min_element(next, [](auto&& d1, auto&& d2) {
+            return std::tie(d1.front().time, d1.front().trip) < std::tie(d2.front().time, d2.front().trip);
+        });
+        result.emplace_back(earliest->front());
+        *earliest = earliest->subspan(1);
+        if (earliest->empty()) next.erase(earliest);
+    }
+    return result;
+}
+
+size_t Departures::getMemoryUsage() const {
+    return departures_.capacity() * sizeof(Departure) + offsets_.capacity() * sizeof(uint32_t) +
+        trips_.capacity() * sizeof(Trip*) + stops_.capacity() * sizeof(Stop*);
+}
@@ -0,0 +1,78 @@
+#ifndef DEPARTURES_HPP_
+#define DEPARTURES_HPP_
+
+#include "DataTypes.hpp"
+#include "Schedule.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+class Timetable;
+
+// trip departing from a stop
+struct Departure {
+    uint32_t time;
+    uint32_t trip;
+
+    // id of the stop and its index along the route of the trip
+    uint32_t stop;
+    uint32_t index;
+};
+
+// departures of all trips from every stop sorted by time (departure board),
+// stored in one array with the departures of every stop next to each other
+class Departures {
+public:
+    // create the departures from the stop times of all trips in the current schedule of timetable
+    void create(Timetable& timetable);
+
+    [[nodiscard]]
+    bool empty() const { return departures_.empty(); }
+
+    // all departures from stop sorted by time
+    [[nodiscard]]
+    std::span<const Departure> getDepartures(const Stop& stop) const {
+        return {departures_.data() + offsets_[stop.getId()], departures_.data() + offsets_[stop.getId() + 1]};
+    }
+
+    // at most count departures from stop at time or later
+    [[nodiscard]]
+    std::span<const Departure> getNextDepartures(const Stop& stop, size_t time, size_t count) const;
+
+    // at most count departures at time or later from any of stops (e.g. all stops with the same name)
+    [[nodiscard]]
+    std::vector<Departure> getNextDepartures(std::span<Stop* const> stops, size_t time, size_t count) const;
+
+    [[nodiscard]]
+    Trip* getTrip(uint32_t id) const { return trips_[id]; }
+
+    [[nodiscard]]
+    Stop* getStop(uint32_t id) const { return stops_[id]; }
+
+    // schedule from which the departures were created
+    [[nodiscard]]
+    const std::shared_ptr<const Schedule>& getSchedule() const { return schedule_; }
+
+    // bytes used by the departures and the indices
+    [[nodiscard]]
+    size_t getMemoryUsage() const;
+
+private:
+    // departures of all stops, sorted by stop id and time
+    std::vector<Departure> departures_;
+
+    // stop id -> index of its first departure
+    std::vector<uint32_t> offsets_;
+
+    // trip id -> trip
+    std::vector<Trip*> trips_;
+
+    // stop id -> stop
+    std::vector<Stop*> stops_;
+
+    std::shared_ptr<const Schedule> schedule_;
+};
+
+#endif
@@ -0,0 +1,632 @@
+#include "GtfsConverter.hpp"
+#include "Parsing.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <span>
+
+namespace {
+
+constexpr size_t READ_BUFFER_SIZE = 1 << 20;
+constexpr size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+// czech (and a few other) letters with diacritics in utf-8 and their ascii replacements
+constexpr std::array<std::pair<std::string_view, char>, 36> ASCII_LETTERS{{
+    {"á", 'a'}, {"č", 'c'}, {"ď", 'd'}, {"é", 'e'}, {"ě", 'e'}, {"í", 'i'}, {"ň", 'n'}, {"ó", 'o'}, {"ř", 'r'},
+    {"š", 's'}, {"ť", 't'}, {"ú", 'u'}, {"ů", 'u'}, {"ý", 'y'}, {"ž", 'z'}, {"ä", 'a'}, {"ö", 'o'}, {"ü", 'u'},
+    {"Á", 'A'}, {"Č", 'C'}, {"Ď", 'D'}, {"É", 'E'}, {"Ě", 'E'}, {"Í", 'I'}, {"Ň", 'N'}, {"Ó", 'O'}, {"Ř", 'R'},
+    {"Š", 'S'}, {"Ť", 'T'}, {"Ú", 'U'}, {"Ů", 'U'}, {"Ý", 'Y'}, {"Ž", 'Z'}, {"Ä", 'A'}, {"Ö", 'O'}, {"Ü", 'U'}
+}};
+
+// reads a csv file by big blocks, fields can be quoted (but without line breaks in them)
+class CsvReader {
+public:
+    explicit CsvReader(const std::string& filename) : in_{filename, std::ios::binary} {
+        if (!in_.is_open() || !next()) return;
+
+        // column names, without the utf-8 byte order mark
+        for (auto&& field: fields_) header_.emplace_back(field);
+        if (!header_.empty() && header_[0].starts_with("\xEF\xBB\xBF")) header_[0].erase(0, 3);
+    }
+
+    [[nodiscard]]
+    bool isOpen() const { return !header_.empty(); }
+
+    // read the next line, returns false at the end of the file
+    bool next() {
+        std::string_view line;
+        if (!readLine(line)) return false;
+        split(line);
+        return true;
+    }
+
+    // index of the column, SIZE_MAX if the file doesn't have it
+    [[nodiscard]]
+    size_t getColumn(std::string_view name) const {
+        auto&& it = std::ranges::find(header_, name);
+        return it != header_.end() ? static_cast<size_t>(it - header_.begin()) : SIZE_MAX;
+    }
+
+    // field of the current line, empty if the line doesn't have the column
+    [[nodiscard]]
+    std::string_view operator[](size_t column) const {
+        return column < fields_.size() ? fields_[column] : std::string_view{};
+    }
+
+private:
+    bool readLine(std::string_view& line) {
+        while (true) {
+            auto&& first = buffer_.data() + begin_;
+            if (auto&& newline = static_cast<char*>(std::memchr(first, '\n', end_ - begin_))) {
+                line = {first, newline};
+                begin_ = static_cast<size_t>(newline - buffer_.data()) + 1;
+                return true;
+            }
+
+            // move the incomplete line to the beginning and read the next block after it
+            std::memmove(buffer_.data(), first, end_ - begin_);
+            end_ -= begin_;
+            begin_ = 0;
+            if (end_ == buffer_.size()) buffer_.resize(2 * buffer_.size());
+            in_.read(buffer_.data() + end_, static_cast<std::streamsize>(buffer_.size() - end_));
+            auto&& count = static_cast<size_t>(in_.gcount());
+            if (count == 0) {
+                // the last line without a line break
+                if (end_ == 0) return false;
+                line = {buffer_.data(), end_};
+                begin_ = end_;
+                return true;
+            }
+            end_ += count;
+        }
+    }
+
+    void split(std::string_view line) {
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        fields_.clear();
+        if (line.find('"') == std::string_view::npos) {
+            for (size_t begin = 0;;) {
+                auto&& comma = line.find(',', begin);
+                fields_.emplace_back(line.substr(begin, comma - begin));
+                if (comma == std::string_view::npos) return;
+                begin = comma + 1;
+            }
+        }
+
+        // quoted fields are copied without the quotes, "" is a quote in a field,
+        // the reserved space is enough so that the fields don't move
+        unquoted_.clear();
+        unquoted_.reserve(line.size());
+        std::vector<std::pair<size_t, size_t>> bounds;
+        size_t begin = 0;
+        bool quoted = false;
+        for (size_t i = 0; i < line.size(); ++i) {
+            char c = line[i];
+            if (quoted && c == '"' && i + 1 < line.size() && line[i + 1] == '"') unquoted_ += line[++i];
+            else if (c == '"') quoted = !quoted;
+            else if (!quoted && c == ',') {
+                bounds.emplace_back(begin, unquoted_.size());
+                begin = unquoted_.size();
+            }
+            else unquoted_ += c;
+        }
+        bounds.emplace_back(begin, unquoted_.size());
+        for (auto&& [first, last]: bounds) fields_.emplace_back(unquoted_.data() + first, last - first);
+    }
+
+    std::ifstream in_;
+    std::vector<char> buffer_ = std::vector<char>(READ_BUFFER_SIZE);
+
+    // unread part of the buffer
+    size_t begin_ = 0;
+    size_t end_ = 0;
+
+    std::vector<std::string> header_;
+    std::vector<std::string_view> fields_;
+    std::string unquoted_;
+};
+
+// writes a csv file through a big buffer
+class CsvWriter {
+public:
+    explicit CsvWriter(const std::filesystem::path& filename) : out_{filename, std::ios::binary} {
+        buffer_.reserve(WRITE_BUFFER_SIZE);
+    }
+
+    CsvWriter(const CsvWriter&) = delete;
+    CsvWriter& operator=(const CsvWriter&) = delete;
+
+    [[nodiscard]]
+    bool isOpen() const { return out_.is_open(); }
+
+    void put(char c) {
+        buffer_ += c;
+    }
+
+    void put(std::string_view s) {
+        buffer_ += s;
+        if (buffer_.size() >= WRITE_BUFFER_SIZE) flush();
+    }
+
+    void putNumber(size_t n) {
+        std::array<char, 20> digits; // NOLINT(cppcoreguidelines-pro-type-member-init)
+        auto&& [last, _] = std::to_chars(digits.data(), digits.data() + digits.size(), n);
+        put(std::string_view{digits.data(), last});
+    }
+
+    // write the rest of the buffer, returns false if the file couldn't be written
+    bool close() {
+        flush();
+        out_.close();
+        return !out_.fail();
+    }
+
+private:
+    void flush() {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+
+    std::ofstream out_;
+    std::string buffer_;
+};
+
+// "hh:mm:ss" (hours can be over 24 for the trips after midnight) -> seconds
+std::optional<uint32_t> parseTime(std::string_view s) {
+    uint32_t time = 0;
+    for (size_t i = 0; i < 3; ++i) {
+        auto&& colon = s.find(':');
+        if ((colon == std::string_view::npos) != (i == 2)) return std::nullopt;
+        auto&& value = parseNumber<uint32_t>(s.substr(0, colon));
+        if (!value) return std::nullopt;
+        time = time * 60 + *value;
+        s.remove_prefix(i < 2 ? colon + 1 : s.size());
+    }
+    return time;
+}
+
+// FNV-1a of route id and stops
+uint64_t getPatternHash(uint32_t route, const std::vector<uint32_t>& stops) {
+    uint64_t hash = 0xcbf29ce484222325 ^ route;
+    for (auto&& stop: stops) {
+        hash ^= stop;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+bool checkColumns(const CsvReader& reader, const std::string& filename, std::span<const std::string_view> columns) {
+    for (auto&& column: columns) {
+        if (reader.getColumn(column) == SIZE_MAX) {
+            std::cout << "Missing column " << column << " in " << filename << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+bool openFile(const CsvReader& reader, const std::string& filename) {
+    if (!reader.isOpen()) std::cout << "Can't read " << filename << '\n';
+    return reader.isOpen();
+}
+
+}
+
+bool GtfsConverter::convert(const std::string& gtfsDirectory, const std::string& outputDirectory) {
+    std::error_code error;
+    std::filesystem::create_directories(outputDirectory, error);
+    if (error) {
+        std::cout << "Can't create " << outputDirectory << '\n';
+        return false;
+    }
+    return readServices(gtfsDirectory) && readStops(gtfsDirectory) && readRoutes(gtfsDirectory) &&
+        readTrips(gtfsDirectory) && convertStopTimes(gtfsDirectory, outputDirectory) &&
+        writeRoutes(outputDirectory) && writeStops(outputDirectory);
+}
+
+bool GtfsConverter::readServices(const std::string& directory) {
+    if (options_.date == 0) return true;
+
+    using namespace std::chrono;
+    year_month_day date{year{static_cast<int>(options_.date / 10000)}, month{options_.date / 100 % 100},
+                        day{options_.date % 100}};
+    if (!date.ok()) {
+        std::cout << "Invalid date " << options_.date << '\n';
+        return false;
+    }
+    constexpr std::array<std::string_view, 7> days{"monday", "tuesday", "wednesday", "thursday", "friday",
+                                                   "saturday", "sunday"};
+    auto&& dayName = days[weekday{sys_days{date}}.iso_encoding() - 1];
+
+    // the regular services, both files are optional
+    CsvReader calendar{directory + "/calendar.txt"};
+    if (calendar.isOpen()) {
+        std::array<std::string_view, 4> columns{"service_id", "start_date", "end_date", dayName};
+        if (!checkColumns(calendar, "calendar.txt", columns)) return false;
+        auto&& serviceColumn = calendar.getColumn("service_id");
+        auto&& startColumn = calendar.getColumn("start_date");
+        auto&& endColumn = calendar.getColumn("end_date");
+        auto&& dayColumn = calendar.getColumn(dayName);
+        while (calendar.next()) {
+            auto&& start = parseNumber<uint32_t>(calendar[startColumn]).value_or(UINT32_MAX);
+            auto&& end = parseNumber<uint32_t>(calendar[endColumn]).value_or(0);
+            services_[std::string{calendar[serviceColumn]}] =
+                start <= options_.date && options_.date <= end && calendar[dayColumn] == "1";
+        }
+    }
+
+    // exceptions - 1 if the service was added on the date, 2 if it was removed
+    CsvReader dates{directory + "/calendar_dates.txt"};
+    if (dates.isOpen()) {
+        std::array<std::string_view, 3> columns{"service_id", "date", "exception_type"};
+        if (!checkColumns(dates, "calendar_dates.txt", columns)) return false;
+        auto&& serviceColumn = dates.getColumn("service_id");
+        auto&& dateColumn = dates.getColumn("date");
+        auto&& typeColumn = dates.getColumn("exception_type");
+        while (dates.next()) {
+            if (parseNumber<uint32_t>(dates[dateColumn]) != options_.date) continue;
+            services_[std::string{dates[serviceColumn]}] = dates[typeColumn] == "1";
+        }
+    }
+
+    if (!calendar.isOpen() && !dates.isOpen()) {
+        std::cout << "Can't read " << directory << "/calendar.txt or calendar_dates.txt\n";
+        return false;
+    }
+    return true;
+}
+
+bool GtfsConverter::readStops(const std::string& directory) {
+    CsvReader reader{directory + "/stops.txt"};
+    constexpr std::array<std::string_view, 2> columns{"stop_id", "stop_name"};
+    if (!openFile(reader, directory + "/stops.txt") || !checkColumns(reader, "stops.txt", columns)) return false;
+
+    auto&& idColumn = reader.getColumn("stop_id");
+    auto&& nameColumn = reader.getColumn("stop_name");
+    auto&& latitudeColumn = reader.getColumn("stop_lat");
+    auto&& longitudeColumn = reader.getColumn("stop_lon");
+    withCoordinates_ = latitudeColumn != SIZE_MAX && longitudeColumn != SIZE_MAX;
+
+    while (reader.next()) {
+        auto&& [_, added] = stopIds_.try_emplace(std::string{reader[idColumn]}, static_cast<uint32_t>(stops_.size()));
+        if (!added) continue;
+        stops_.push_back({toName(reader[nameColumn]), std::string{reader[latitudeColumn]},
+                          std::string{reader[longitudeColumn]}});
+    }
+    return true;
+}
+
+bool GtfsConverter::readRoutes(const std::string& directory) {
+    CsvReader reader{directory + "/routes.txt"};
+    constexpr std::array<std::string_view, 2> columns{"route_id", "route_type"};
+    if (!openFile(reader, directory + "/routes.txt") || !checkColumns(reader, "routes.txt", columns)) return false;
+
+    auto&& idColumn = reader.getColumn("route_id");
+    auto&& typeColumn = reader.getColumn("route_type");
+    auto&& shortNameColumn = reader.getColumn("route_short_name");
+    auto&& longNameColumn = reader.getColumn("route_long_name");
+    auto&& regionalColumn = reader.getColumn("is_regional");
+
+    while (reader.next()) {
+        auto&& type = parseNumber<uint32_t>(reader[typeColumn]);
+        if (!type || std::ranges::find(options_.routeTypes, *type) == options_.routeTypes.end()) continue;
+        if (!options_.regional && reader[regionalColumn] == "1") continue;
+
+        // some feeds have just the long names
+        auto&& name = reader[shortNameColumn].empty() ? reader[longNameColumn] : reader[shortNameColumn];
+        auto&& [_, added] = routeIds_.try_emplace(std::string{reader[idColumn]}, static_cast<uint32_t>(routes_.size()));
+        if (added) routes_.push_back({toName(name), *type});
+    }
+    return true;
+}
+
+bool GtfsConverter::readTrips(const std::string& directory) {
+    CsvReader reader{directory + "/trips.txt"};
+    constexpr std::array<std::string_view, 3> columns{"trip_id", "route_id", "service_id"};
+    if (!openFile(reader, directory + "/trips.txt") || !checkColumns(reader, "trips.txt", columns)) return false;
+
+    auto&& idColumn = reader.getColumn("trip_id");
+    auto&& routeColumn = reader.getColumn("route_id");
+    auto&& serviceColumn = reader.getColumn("service_id");
+    auto&& headsignColumn = reader.getColumn("trip_headsign");
+    auto&& directionColumn = reader.getColumn("direction_id");
+
+    std::string key;
+    while (reader.next()) {
+        key = reader[routeColumn];
+        auto&& route = routeIds_.find(key);
+        if (route == routeIds_.end()) continue;
+
+        // trips not running on the date
+        if (options_.date != 0) {
+            key = reader[serviceColumn];
+            if (auto&& service = services_.find(key); service == services_.end() || !service->second) {
+                ++skippedTrips_;
+                continue;
+            }
+        }
+        auto&& direction = parseNumber<uint32_t>(reader[directionColumn]).value_or(0);
+        auto&& [_, added] = tripIds_.try_emplace(std::string{reader[idColumn]}, static_cast<uint32_t>(trips_.size()));
+        if (added) trips_.push_back({route->second, direction, toName(reader[headsignColumn])});
+    }
+    return true;
+}
+
+bool GtfsConverter::convertStopTimes(const std::string& directory, const std::string& outputDirectory) {
+    CsvReader reader{directory + "/stop_times.txt"};
+    constexpr std::array<std::string_view, 5> columns{"trip_id", "arrival_time", "departure_time", "stop_id",
+                                                      "stop_sequence"};
+    if (!openFile(reader, directory + "/stop_times.txt") || !checkColumns(reader, "stop_times.txt", columns)) {
+        return false;
+    }
+    auto&& tripColumn = reader.getColumn("trip_id");
+    auto&& arrivalColumn = reader.getColumn("arrival_time");
+    auto&& departureColumn = reader.getColumn("departure_time");
+    auto&& stopColumn = reader.getColumn("stop_id");
+    auto&& sequenceColumn = reader.getColumn("stop_sequence");
+
+    CsvWriter out{std::filesystem::path{outputDirectory} / "stop_times.csv"};
+    if (!out.isOpen()) {
+        std::cout << "Can't write " << outputDirectory << "/stop_times.csv\n";
+        return false;
+    }
+    out.put("trip_index,arrival_time,departure_time,stop_index\n");
+
+    struct StopTime {
+        uint32_t sequence;
+        uint32_t stop;
+        uint32_t arrival;
+        uint32_t departure;
+    };
+
+    // arrival and departure of a stop time without the times
+    constexpr uint32_t UNTIMED = UINT32_MAX;
+
+    // stop times of the scanned trip, it's skipped if some of them are invalid
+    std::string scannedId;
+    uint32_t scannedTrip = UINT32_MAX;
+    std::vector<StopTime> stopTimes;
+    std::vector<uint32_t> stops;
+    bool valid = false;
+
+    // the stop times of every trip have to be next to each other, the trips are written one by one
+    std::vector<bool> scanned(trips_.size());
+
+    auto addTrip = [&]() {
+        if (scannedTrip == UINT32_MAX) return;
+        if (!valid || stopTimes.size() < 2) {
+            ++skippedTrips_;
+            return;
+        }
+        if (!std::ranges::is_sorted(stopTimes, {}, &StopTime::sequence)) {
+            std::ranges::sort(stopTimes, {}, &StopTime::sequence);
+        }
+
+        // the times are optional except at the first and the last stop, the times of the stops between
+        // two timed stops are interpolated evenly (the distances aren't known)
+        if (stopTimes.front().arrival == UNTIMED || stopTimes.back().arrival == UNTIMED) {
+            ++skippedTrips_;
+            return;
+        }
+        for (size_t i = 1, timed = 0; i < stopTimes.size(); ++i) {
+            if (stopTimes[i].arrival == UNTIMED) continue;
+            auto&& from = stopTimes[timed].departure;
+            auto&& to = std::max(stopTimes[i].arrival, from);
+            for (size_t j = timed + 1; j < i; ++j) {
+                auto&& time = from + static_cast<uint32_t>(uint64_t{to - from} * (j - timed) / (i - timed));
+                stopTimes[j].arrival = stopTimes[j].departure = time;
+            }
+            timed = i;
+        }
+
+        // the stops are numbered in the order of their first use
+        stops.clear();
+        for (auto&& stopTime: stopTimes) {
+            auto&& stop = stops_[stopTime.stop];
+            if (stop.index == UINT32_MAX) {
+                stop.index = static_cast<uint32_t>(usedStops_.size());
+                usedStops_.emplace_back(stopTime.stop);
+            }
+            stops.emplace_back(stop.index);
+        }
+
+        auto&& trip = trips_[scannedTrip];
+        trip.index = static_cast<uint32_t>(tripCount_++);
+        convertedTrips_.push_back({scannedTrip, getPattern(trip.route, stops), static_cast<uint32_t>(times_.size())});
+        for (size_t i = 0; i < stopTimes.size(); ++i) {
+            times_.emplace_back(stopTimes[i].arrival);
+            times_.emplace_back(stopTimes[i].departure);
+
+            out.putNumber(trip.index);
+            out.put(',');
+            out.putNumber(stopTimes[i].arrival);
+            out.put(',');
+            out.putNumber(stopTimes[i].departure);
+            out.put(',');
+            out.putNumber(stops[i]);
+            out.put('\n');
+        }
+    };
+
+    std::string key;
+    while (reader.next()) {
+        if (auto&& tripId = reader[tripColumn]; tripId != scannedId) {
+            addTrip();
+            scannedId = tripId;
+            stopTimes.clear();
+            valid = true;
+
+            // the trips of the other routes are skipped
+            auto&& trip = tripIds_.find(scannedId);
+            scannedTrip = trip != tripIds_.end() ? trip->second : UINT32_MAX;
+            if (scannedTrip != UINT32_MAX && scanned[scannedTrip]) {
+                std::cout << "stop_times.txt is not grouped by trip_id (trip " << scannedId << ")\n";
+                return false;
+            }
+            if (scannedTrip != UINT32_MAX) scanned[scannedTrip] = true;
+        }
+        if (scannedTrip == UINT32_MAX || !valid) continue;
+
+        key = reader[stopColumn];
+        auto&& stop = stopIds_.find(key);
+        auto&& sequence = parseNumber<uint32_t>(reader[sequenceColumn]);
+        auto&& arrival = parseTime(reader[arrivalColumn]);
+        auto&& departure = parseTime(reader[departureColumn]);
+
+        if (stop == stopIds_.end() || !sequence) {
+            valid = false;
+            continue;
+        }
+
+        // the stop times without the times are kept, they are filled when the trip is sorted
+        if (!arrival && !departure) arrival = departure = UNTIMED;
+        if (!arrival) arrival = departure;
+        if (!departure) departure = arrival;
+        stopTimes.push_back({*sequence, stop->second, *arrival, *departure});
+    }
+    addTrip();
+
+    if (!out.close()) {
+        std::cout << "Can't write " << outputDirectory << "/stop_times.csv\n";
+        return false;
+    }
+    return true;
+}
+
+bool GtfsConverter::writeRoutes(const std::string& outputDirectory) {
+    CsvWriter routes{std::filesystem::path{outputDirectory} / "routes.csv"};
+    CsvWriter trips{std::filesystem::path{outputDirectory} / "trips.csv"};
+    routes.put("route_index,route_short_name,route_type\n");
+    trips.put("trip_index,route_index,trip_headsign,direction_id\n");
+
+    // trips of every pattern
+    std::vector<uint32_t> offsets(patterns_.size() + 1);
+    for (auto&& trip: convertedTrips_) ++offsets[trip.pattern + 1];
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<uint32_t> order(convertedTrips_.size());
+    for (uint32_t t = 0; t < convertedTrips_.size(); ++t) order[offsets[convertedTrips_[t].pattern]++] = t;
+
+    // the offsets are moved to the ends of the patterns
+    std::vector<std::vector<uint32_t>> lanes;
+    for (uint32_t p = 0, begin = 0; p < patterns_.size(); begin = offsets[p++]) {
+        std::span patternTrips{order.data() + begin, order.data() + offsets[p]};
+        std::ranges::sort(patternTrips, [this](uint32_t a, uint32_t b) {
+            auto&& timesA = times_.data() + convertedTrips_[a].times;
+            auto&& timesB = times_.data() + convertedTrips_[b].times;
+            return std::pair{timesA[1], timesA[0]} < std::pair{timesB[1], timesB[0]};
+        });
+
+        // a route can't have trips overtaking each other (the searches expect the same order at all stops),
+        // every trip is added to the first route where it doesn't overtake the last trip
+        lanes.clear();
+        for (auto&& t: patternTrips) {
+            auto&& lane = std::ranges::find_if(lanes, [&](auto&& l) {
+                return !isLater(convertedTrips_[l.back()], convertedTrips_[t]);
+            });
+            if (lane != lanes.end()) lane->emplace_back(t);
+            else lanes.push_back({t});
+        }
+
+        auto&& route = routes_[patterns_[p].route];
+        for (auto&& lane: lanes) {
+            routes.putNumber(routeCount_);
+            routes.put(',');
+            routes.put(route.name);
+            routes.put(',');
+            routes.putNumber(route.type);
+            routes.put('\n');
+            for (auto&& t: lane) {
+                auto&& trip = trips_[convertedTrips_[t].trip];
+                trips.putNumber(trip.index);
+                trips.put(',');
+                trips.putNumber(routeCount_);
+                trips.put(',');
+                trips.put(trip.headsign);
+                trips.put(',');
+                trips.putNumber(trip.direction);
+                trips.put('\n');
+            }
+            ++routeCount_;
+        }
+    }
+
+    if (!routes.close() || !trips.close()) {
+        std::cout << "Can't write routes.csv and trips.csv into " << outputDirectory << '\n';
+        return false;
+    }
+    return true;
+}
+
+bool GtfsConverter::writeStops(const std::string& outputDirectory) {
+    CsvWriter out{std::filesystem::path{outputDirectory} / "stops.csv"};
+    out.put(withCoordinates_ ? "stop_index,stop_name,stop_lat,stop_lon\n" : "stop_index,stop_name\n");
+    for (size_t i = 0; i < usedStops_.size(); ++i) {
+        auto&& stop = stops_[usedStops_[i]];
+        out.putNumber(i);
+        out.put(',');
+        out.put(stop.name);
+        if (withCoordinates_) {
+            out.put(',');
+            out.put(stop.latitude);
+            out.put(',');
+            out.put(stop.longitude);
+        }
+        out.put('\n');
+    }
+    if (!out.close()) {
+        std::cout << "Can't write " << outputDirectory << "/stops.csv\n";
+        return false;
+    }
+    return true;
+}
+
+uint32_t GtfsConverter::getPattern(uint32_t route, const std::vector<uint32_t>& stops) {
+    auto&& hash = getPatternHash(route, stops);
+    for (auto&& [it, last] = patternIds_.equal_range(hash); it != last; ++it) {
+        auto&& pattern = patterns_[it->second];
+        if (pattern.route == route && pattern.stops == stops) return it->second;
+    }
+    auto&& id = static_cast<uint32_t>(patterns_.size());
+    patterns_.push_back({route, stops});
+    patternIds_.emplace(hash, id);
+    return id;
+}
+
+bool GtfsConverter::isLater(const ConvertedTrip& a, const ConvertedTrip& b) const {
+    auto&& count = 2 * patterns_[a.pattern].stops.size();
+    return !std::equal(times_.data() + a.times, times_.data() + a.times + count, times_.data() + b.times,
+                       std::less_equal{});
+}
+
+std::string GtfsConverter::toName(std::string_view name) const {
+    std::string result;
+    result.reserve(name.size());
+    for (size_t i = 0; i < name.size(); ++i) {
+        // the csv files of the timetable don't have quoted fields, "A, B" -> "A B"
+        if (name[i] == ',') {
+            if (i + 1 < name.size() && name[i + 1] != ' ') result += ' ';
+            continue;
+        }
+        if (options_.ascii && static_cast<unsigned char>(name[i]) >= 0x80) {
+            auto&& letter = std::ranges::find_if(ASCII_LETTERS, [&](auto&& l) {
+                return name.substr(i).starts_with(l.first);
+            });
+            if (letter != ASCII_LETTERS.end()) {
+                result += letter->second;
+                i += letter->first.size() - 1;
+                continue;
+            }
+        }
+        result += name[i];
+    }
+    return result;
+}
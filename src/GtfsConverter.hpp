@@ -0,0 +1,147 @@
+#ifndef GTFSCONVERTER_HPP_
+#define GTFSCONVERTER_HPP_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// converts a GTFS feed (stops.txt, routes.txt, trips.txt, stop_times.txt) into the csv files read by Timetable,
+// the stop times are streamed, only the times of the kept trips are held in memory (8 bytes per stop)
+class GtfsConverter {
+public:
+    struct Options {
+        // GTFS route types to keep (tram, metro and bus by default)
+        std::vector<size_t> routeTypes{0, 1, 3};
+
+        // keep the regional routes (marked in the is_regional column of the PID feed)
+        bool regional = false;
+
+        // keep only the trips running on the date (yyyymmdd, needs calendar.txt or calendar_dates.txt),
+        // all trips if 0
+        uint32_t date = 0;
+
+        // replace the czech letters with diacritics by ascii ones, like in the names of data/
+        bool ascii = true;
+    };
+
+    explicit GtfsConverter(Options options) : options_(std::move(options)) {}
+
+    // convert the feed in gtfsDirectory and write the csv files into outputDirectory,
+    // returns false if a file can't be read or written
+    bool convert(const std::string& gtfsDirectory, const std::string& outputDirectory);
+
+    // sizes of the written timetable
+    [[nodiscard]]
+    size_t getStopCount() const { return usedStops_.size(); }
+
+    [[nodiscard]]
+    size_t getRouteCount() const { return routeCount_; }
+
+    [[nodiscard]]
+    size_t getTripCount() const { return tripCount_; }
+
+    [[nodiscard]]
+    size_t getStopTimeCount() const { return times_.size() / 2; }
+
+    // trips of the kept routes left out (not running on the date, unknown stops or less than 2 stops)
+    [[nodiscard]]
+    size_t getSkippedTripCount() const { return skippedTrips_; }
+
+private:
+    struct GtfsStop {
+        std::string name;
+        std::string latitude;
+        std::string longitude;
+
+        // index in the output, UINT32_MAX till the stop is used by a trip
+        uint32_t index = UINT32_MAX;
+    };
+
+    struct GtfsRoute {
+        std::string name;
+        size_t type;
+    };
+
+    struct GtfsTrip {
+        uint32_t route;
+        uint32_t direction;
+        std::string headsign;
+
+        // index in the output (order in stop_times.txt), UINT32_MAX if the trip is skipped
+        uint32_t index = UINT32_MAX;
+    };
+
+    // trip split by its sequence of stops
+    struct ConvertedTrip {
+        uint32_t trip;
+        uint32_t pattern;
+
+        // index of its first (arrival, departure) in times_
+        uint32_t times;
+    };
+
+    // route of the feed with one sequence of stops
+    struct Pattern {
+        uint32_t route;
+        std::vector<uint32_t> stops;
+    };
+
+    bool readServices(const std::string& directory);
+    bool readStops(const std::string& directory);
+    bool readRoutes(const std::string& directory);
+    bool readTrips(const std::string& directory);
+    bool convertStopTimes(const std::string& directory, const std::string& outputDirectory);
+
+    // split the patterns into routes without overtaking trips and write the routes and the trips
+    bool writeRoutes(const std::string& outputDirectory);
+    bool writeStops(const std::string& outputDirectory);
+
+    // returns the pattern of route with stops, adds a new one if needed
+    uint32_t getPattern(uint32_t route, const std::vector<uint32_t>& stops);
+
+    // true if trip a arrives or departs later than trip b at some stop of their pattern
+    [[nodiscard]]
+    bool isLater(const ConvertedTrip& a, const ConvertedTrip& b) const;
+
+    [[nodiscard]]
+    std::string toName(std::string_view name) const;
+
+    Options options_;
+
+    // services running on options_.date
+    std::unordered_map<std::string, bool> services_;
+
+    std::vector<GtfsStop> stops_;
+    std::unordered_map<std::string, uint32_t> stopIds_;
+    bool withCoordinates_ = false;
+
+    // kept routes
+    std::vector<GtfsRoute> routes_;
+    std::unordered_map<std::string, uint32_t> routeIds_;
+
+    // trips of the kept routes
+    std::vector<GtfsTrip> trips_;
+    std::unordered_map<std::string, uint32_t> tripIds_;
+
+    std::vector<Pattern> patterns_;
+
+    // hash of route and stops -> pattern
+    std::unordered_multimap<uint64_t, uint32_t> patternIds_;
+
+    // stops in the order of the output
+    std::vector<uint32_t> usedStops_;
+
+    std::vector<ConvertedTrip> convertedTrips_;
+
+    // arrival and departure of all converted trips at every stop of their pattern
+    std::vector<uint32_t> times_;
+
+    size_t routeCount_ = 0;
+    size_t tripCount_ = 0;
+    size_t skippedTrips_ = 0;
+};
+
+#endif
@@ -6,12 +6,12 @@
 #include <cctype>
 
 [[maybe_unused]]
-InputReader::InputReader(const std::unordered_map<size_t, Stop>& stops) {
+InputReader::InputReader(Timetable& timetable) : timetable_(timetable) {
     // fill in stopNames_
-    for (auto&& [_, stop]: stops) {
-        if (!stopNames_.contains(stop.getName())) {
-            std::string_view name{stop.getName()}; // original name
-            std::string nameLower{stop.getName()}; // name in lowercase
+    for (auto&& [_, stop]: timetable.getStops()) {
+        std::string_view name{timetable.getName(stop)}; // original name
+        if (!stopNames_.contains(std::string{name})) {
+            std::string nameLower{name}; // name in lowercase
             std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(),
                            [](unsigned char c){ return std::tolower(c); });
             stopNames_.emplace(std::move(nameLower), name);
@@ -37,6 +37,14 @@ std::string InputReader::readName(bool start) const {
     while (true) {
         std::cout << "Enter the " << (start ? "starting point": "destination") << ": ";
         std::getline(std::cin, name);
+
+        // coordinates can be used if there are stops around
+        if (auto&& point = Coordinates::parse(name); point && !timetable_.getStopGrid().empty()) {
+            if (!timetable_.getStopsAround(*point).empty()) return name;
+            std::cout << "No stops around!\n";
+            continue;
+        }
+
         auto nameLower = name;
         std::transform(nameLower.begin(), nameLower.end(), nameLower.begin(),
                        [](unsigned char c){ return std::tolower(c); });
@@ -107,3 +115,8 @@ std::string InputReader::readTime() {
     startTime_ = readTime();
 }
 
+
+[[maybe_unused]] void InputReader::readBoard() {
+    startName_ = readName(true);
+    startTime_ = readTime();
+}
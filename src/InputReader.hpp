@@ -10,12 +10,16 @@
 class [[maybe_unused]] InputReader {
 public:
     [[maybe_unused]]
-    explicit InputReader(const std::unordered_map<size_t, Stop>& stops);
+    explicit InputReader(Timetable& timetable);
 
     // read and store all user input
     [[maybe_unused]]
     void read();
 
+    // read just the stop (stored as the start name) and the time for the departure board
+    [[maybe_unused]]
+    void readBoard();
+
     [[maybe_unused]] [[nodiscard]]
     const std::string& getStartName() const { return startName_; }
 
@@ -45,6 +49,8 @@ private:
     // min length of a substring
     static constexpr size_t MIN_LENGTH = 2;
 
+    const Timetable& timetable_;
+
     // maps name in lowercase to original name
     std::unordered_map<std::string, std::string_view> stopNames_;
 
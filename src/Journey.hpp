@@ -0,0 +1,87 @@
+#ifndef JOURNEY_HPP_
+#define JOURNEY_HPP_
+
+#include "DataTypes.hpp"
+
+#include <array>
+#include <algorithm>
+#include <cstdint>
+
+// one trip of a journey - ride trip from stop `from` to stop `to`
+struct Leg {
+    Trip* trip = nullptr;
+    Stop* from = nullptr;
+    Stop* to = nullptr;
+
+    // indices of from/to along the route of the trip
+    uint32_t fromIndex = 0;
+    uint32_t toIndex = 0;
+
+    // times in the schedule used by the search (the trip may be delayed again since)
+    uint32_t departureTime = 0;
+    uint32_t arrivalTime = 0;
+
+    [[nodiscard]]
+    size_t getDepartureTime() const { return departureTime; }
+
+    [[nodiscard]]
+    size_t getArrivalTime() const { return arrivalTime; }
+};
+
+// resulting connection of a search, fixed capacity so it can live on the stack
+class Journey {
+public:
+    // max number of legs (trips) of a journey
+    static constexpr size_t MAX_LEGS = 8;
+
+    void clear() { size_ = 0; arrivalTime_ = SIZE_MAX; complete_ = true; }
+
+    // append leg, returns false if the journey is full
+    bool addLeg(const Leg& leg) {
+        if (size_ == MAX_LEGS) return false;
+        legs_[size_++] = leg;
+        return true;
+    }
+
+    // legs are usually collected from the destination, fix the order
+    void reverse() { std::reverse(legs_.begin(), legs_.begin() + size_); }
+
+    [[nodiscard]]
+    bool found() const { return arrivalTime_ != SIZE_MAX; }
+
+    [[nodiscard]]
+    size_t size() const { return size_; }
+
+    [[nodiscard]]
+    bool empty() const { return size_ == 0; }
+
+    [[nodiscard]]
+    const Leg* begin() const { return legs_.data(); }
+
+    [[nodiscard]]
+    const Leg* end() const { return legs_.data() + size_; }
+
+    [[nodiscard]]
+    const Leg& operator[](size_t i) const { return legs_[i]; }
+
+    // arrival time at the destination (including the final transfer)
+    [[nodiscard]]
+    size_t getArrivalTime() const { return arrivalTime_; }
+
+    void setArrivalTime(size_t time) { arrivalTime_ = time; }
+
+    // false if the search was stopped by the limits of the query,
+    // the journey may not be the best one (or there's none because of the timeout)
+    [[nodiscard]]
+    bool isComplete() const { return complete_; }
+
+    void setComplete(bool complete) { complete_ = complete; }
+
+private:
+    std::array<Leg, MAX_LEGS> legs_{};
+    size_t size_ = 0;
+    size_t arrivalTime_ = SIZE_MAX;
+    bool complete_ = true;
+};
+
+#endif
@@ -0,0 +1,201 @@
+#include "JourneyFormatter.hpp"
+
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+constexpr size_t HOUR_SECONDS = 3600;
+constexpr size_t MINUTE_SECONDS = 60;
+
+// appends to a fixed buffer, remembers if anything didn't fit
+class BufferWriter {
+public:
+    explicit BufferWriter(std::span<char> buffer) :
+        begin_(buffer.data()), pos_(buffer.data()), end_(buffer.data() + buffer.size()) {}
+
+    void put(char c) {
+        if (pos_ == end_) { overflow_ = true; return; }
+        *pos_++ = c;
+    }
+
+    void put(std::string_view s) {
+        if (static_cast<size_t>(end_ - pos_) < s.size()) { overflow_ = true; return; }
+        std::memcpy(pos_, s.data(), s.size());
+        pos_ += s.size();
+    }
+
+    void putNumber(size_t n) {
+        auto&& [ptr, ec] = std::to_chars(pos_, end_, n);
+        if (ec != std::errc{}) { overflow_ = true; return; }
+        pos_ = ptr;
+    }
+
+    void putTime(size_t time, bool leadingZero, bool roundSeconds, bool roundNextDay) {
+        char buf[JourneyFormatter::MAX_TIME_LENGTH];
+        auto&& last = JourneyFormatter::writeTime(buf, time, leadingZero, roundSeconds, roundNextDay);
+        put(std::string_view{buf, static_cast<size_t>(last - buf)});
+    }
+
+    // put string as json string literal
+    void putJsonString(std::string_view s) {
+        put('"');
+        for (char c: s) {
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(c);
+            }
+            else if (static_cast<unsigned char>(c) < 0x20) {
+                constexpr char hex[] = "0123456789abcdef";
+                put("\\u00");
+                put(hex[(c >> 4) & 0xf]);
+                put(hex[c & 0xf]);
+            }
+            else put(c);
+        }
+        put('"');
+    }
+
+    [[nodiscard]]
+    std::optional<size_t> result() const {
+        if (overflow_) return std::nullopt;
+        return static_cast<size_t>(pos_ - begin_);
+    }
+
+private:
+    char* const begin_;
+    char* pos_;
+    char* const end_;
+    bool overflow_ = false;
+};
+
+// write n as at least two digits
+char* writeTwoDigits(char* out, size_t n) {
+    if (n < 10) *out++ = '0';
+    return std::to_chars(out, out + 20, n).ptr;
+}
+
+void writeJsonStop(BufferWriter& writer, const StringPool& strings, const Stop* stop) {
+    writer.put("{\"id\":");
+    writer.putNumber(stop->getOriginalId());
+    writer.put(",\"name\":");
+    writer.putJsonString(strings.get(stop->getNameId()));
+    writer.put('}');
+}
+
+}
+
+char* JourneyFormatter::writeTime(char* out, size_t timeInSeconds, bool leadingZero,
+                                  bool roundSeconds, bool roundNextDay) {
+    if (timeInSeconds == SIZE_MAX) {
+        std::memcpy(out, "inf", 3);
+        return out + 3;
+    }
+
+    if (roundNextDay) {
+        timeInSeconds %= HOUR_SECONDS * 24;
+    }
+
+    if (roundSeconds) {
+        auto seconds = timeInSeconds % MINUTE_SECONDS;
+        if (seconds >= 30) { // round up seconds
+            timeInSeconds += MINUTE_SECONDS - seconds;
+        }
+    }
+
+    auto hours = timeInSeconds / HOUR_SECONDS;
+    out = leadingZero ? writeTwoDigits(out, hours) : std::to_chars(out, out + 20, hours).ptr;
+    timeInSeconds %= HOUR_SECONDS;
+    *out++ = ':';
+    out = writeTwoDigits(out, timeInSeconds / MINUTE_SECONDS);
+
+    if (roundSeconds) return out;
+
+    *out++ = ':';
+    return writeTwoDigits(out, timeInSeconds % MINUTE_SECONDS);
+}
+
+std::optional<size_t> JourneyFormatter::writeText(const Journey& journey, const StringPool& strings,
+                                                  std::span<char> buffer, bool pretty) {
+    BufferWriter writer{buffer};
+    if (!journey.found()) {
+        writer.put(journey.isComplete() ? "No connection found!\n" : "Search stopped, no connection found yet!\n");
+        return writer.result();
+    }
+    for (auto&& leg: journey) {
+        auto&& routeName = strings.get(leg.trip->getRoute()->getNameId());
+        if (pretty) {
+            // departure
+            writer.putTime(leg.getDepartureTime(), false, true, true);
+            writer.put(' ');
+            writer.put(strings.get(leg.from->getNameId()));
+            writer.put(" >> ");
+            // arrival
+            writer.putTime(leg.getArrivalTime(), false, true, true);
+            writer.put(' ');
+            writer.put(strings.get(leg.to->getNameId()));
+            writer.put(' ');
+            writer.put(routeName);
+            writer.put('\n');
+        }
+        else {
+            // used for debugging
+            writer.put("Departure: ");
+            writer.putNumber(leg.from->getOriginalId());
+            writer.put(' ');
+            writer.put(strings.get(leg.from->getNameId()));
+            writer.put(' ');
+            writer.putTime(leg.getDepartureTime(), false, false, false);
+            writer.put(' ');
+            writer.put(routeName);
+            writer.put('\n');
+
+            writer.put("Arrival: ");
+            writer.putNumber(leg.to->getOriginalId());
+            writer.put(' ');
+            writer.put(strings.get(leg.to->getNameId()));
+            writer.put(' ');
+            writer.putTime(leg.getArrivalTime(), false, false, false);
+            writer.put(' ');
+            writer.put(routeName);
+            writer.put('\n');
+        }
+    }
+    if (!journey.isComplete()) writer.put("Search stopped, the connection may not be the fastest one\n");
+    return writer.result();
+}
+
+std::optional<size_t> JourneyFormatter::writeJson(const Journey& journey, const StringPool& strings,
+                                                  std::span<char> buffer) {
+    BufferWriter writer{buffer};
+    if (!journey.found()) {
+        writer.put(journey.isComplete() ? "{\"found\":false}" : "{\"found\":false,\"complete\":false}");
+        return writer.result();
+    }
+    // all times are in seconds since midnight
+    writer.put("{\"found\":true,\"arrival\":");
+    writer.putNumber(journey.getArrivalTime());
+    writer.put(",\"legs\":[");
+    for (size_t i = 0; i < journey.size(); ++i) {
+        auto&& leg = journey[i];
+        if (i > 0) writer.put(',');
+        writer.put("{\"route\":");
+        writer.putJsonString(strings.get(leg.trip->getRoute()->getNameId()));
+        writer.put(",\"headsign\":");
+        writer.putJsonString(strings.get(leg.trip->getHeadsignId()));
+        writer.put(",\"from\":");
+        writeJsonStop(writer, strings, leg.from);
+        writer.put(",\"departure\":");
+        writer.putNumber(leg.getDepartureTime());
+        writer.put(",\"to\":");
+        writeJsonStop(writer, strings, leg.to);
+        writer.put(",\"arrival\":");
+        writer.putNumber(leg.getArrivalTime());
+        writer.put('}');
+    }
+    writer.put(']');
+    // only interrupted searches, the complete ones keep the original output
+    if (!journey.isComplete()) writer.put(",\"complete\":false");
+    writer.put('}');
+    return writer.result();
+}
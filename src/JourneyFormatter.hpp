@@ -0,0 +1,37 @@
+#ifndef JOURNEYFORMATTER_HPP_
+#define JOURNEYFORMATTER_HPP_
+
+#include "Journey.hpp"
+#include "StringPool.hpp"
+
+#include <optional>
+#include <span>
+#include <string_view>
+
+// writes journeys into a caller-provided buffer, never allocates
+class JourneyFormatter {
+public:
+    // max length of a time written by writeTime
+    static constexpr size_t MAX_TIME_LENGTH = 24;
+
+    // names are looked up in strings (the string pool of the timetable)
+
+    // write journey as text (set pretty=true for the user)
+    // returns the number of written characters or nullopt if the buffer is too small
+    [[nodiscard]]
+    static std::optional<size_t> writeText(const Journey& journey, const StringPool& strings,
+                                           std::span<char> buffer, bool pretty=false);
+
+    // write journey as a single json object
+    // returns the number of written characters or nullopt if the buffer is too small
+    [[nodiscard]]
+    static std::optional<size_t> writeJson(const Journey& journey, const StringPool& strings,
+                                           std::span<char> buffer);
+
+    // write human-readable time from timeInSeconds to out (at least MAX_TIME_LENGTH chars)
+    // returns pointer past the last written character
+    static char* writeTime(char* out, size_t timeInSeconds, bool leadingZero=false,
+                           bool roundSeconds=false, bool roundNextDay=false);
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "Numa.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+// cpus of a cpulist like "0-3,8-11"
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::istringstream in{list};
+    for (std::string range; std::getline(in, range, ',');) {
+        if (range.empty() || range == "\n") continue;
+        auto&& dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) cpus.emplace_back(cpu);
+    }
+    return cpus;
+}
+
+}
+
+NumaTopology::NumaTopology() {
+    // nodes sorted by their number, nodes with memory only are skipped
+    std::vector<std::pair<int, std::vector<int>>> nodes;
+    std::error_code error;
+    for (auto&& entry: std::filesystem::directory_iterator{"/sys/devices/system/node", error}) {
+        auto&& name = entry.path().filename().string();
+        if (!name.starts_with("node") || name.size() == 4 ||
+            !std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        std::ifstream in{entry.path() / "cpulist"};
+        std::string list;
+        if (!std::getline(in, list)) continue;
+        auto&& cpus = parseCpuList(list);
+        if (!cpus.empty()) nodes.emplace_back(std::stoi(name.substr(4)), std::move(cpus));
+    }
+    std::ranges::sort(nodes);
+    for (auto&& [_, cpus]: nodes) nodes_.emplace_back(std::move(cpus));
+
+    if (nodes_.empty()) {
+        nodes_.emplace_back();
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+            nodes_.back().emplace_back(static_cast<int>(cpu));
+        }
+    }
+}
+
+bool NumaTopology::pinThread(size_t node) const {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto&& cpu: nodes_[node]) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -0,0 +1,46 @@
+#ifndef NUMA_HPP_
+#define NUMA_HPP_
+
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// NUMA nodes of the machine and their cpus (read from /sys, without libnuma)
+// used to keep a copy of the timetable on every node, so that the searches read only local memory
+class NumaTopology {
+public:
+    // read the nodes with cpus, one node with all cpus if they can't be read
+    NumaTopology();
+
+    [[nodiscard]]
+    size_t getNodeCount() const { return nodes_.size(); }
+
+    [[nodiscard]]
+    const std::vector<int>& getCpus(size_t node) const { return nodes_[node]; }
+
+    // node of the i-th thread when the threads are spread over the nodes evenly
+    [[nodiscard]]
+    size_t getThreadNode(size_t thread) const { return thread % nodes_.size(); }
+
+    // pin the calling thread to the cpus of node, returns false if it can't be pinned
+    bool pinThread(size_t node) const;
+
+    // call f(node) for every node in a thread pinned to the node, one node after another,
+    // the memory allocated (and first written) by f is placed on the node
+    template<typename F>
+    void runOnNodes(F&& f) const {
+        for (size_t node = 0; node < nodes_.size(); ++node) {
+            std::thread thread{[&f, node, this]() {
+                pinThread(node);
+                f(node);
+            }};
+            thread.join();
+        }
+    }
+
+private:
+    // cpus of every node
+    std::vector<std::vector<int>> nodes_;
+};
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef PARSING_HPP_
+#define PARSING_HPP_
+
+#include <charconv>
+#include <optional>
+#include <string_view>
+
+// the whole string as a number, nullopt if it isn't a number or it doesn't fit into T
+template<typename T>
+std::optional<T> parseNumber(std::string_view s) {
+    T value{};
+    auto&& [last, error] = std::from_chars(s.data(), s.data() + s.size(), value);
+    if (error != std::errc{} || last != s.data() + s.size()) return std::nullopt;
+    return value;
+}
+
+#endif
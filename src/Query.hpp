@@ -0,0 +1,52 @@
+#ifndef QUERY_HPP_
+#define QUERY_HPP_
+
+#include "DataTypes.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// stop of the timetable and the time (in seconds) needed to walk between it and the source/target
+struct StopOffset {
+    Stop* stop;
+    size_t offset;
+};
+
+// limits of the work of one search, the search stops when any of them is reached
+// and the best journey found so far is returned (see Journey::isComplete)
+struct SearchLimits {
+    // the search stops at this time
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+
+    // max number of scanned routes (raptor), trip segments (trip-based) or connections (csa)
+    size_t maxWork = SIZE_MAX;
+
+    // the search stops when another thread sets it
+    const std::atomic<bool>* cancelled = nullptr;
+};
+
+// source and target of one search, they are not stops of the timetable
+// but sets of stops reachable from the source and stops from which the target can be reached
+// (e.g. all stops with the same name or stops around an address)
+struct Query {
+    // stops reachable from the source, boarded at startTime + offset
+    std::vector<StopOffset> access;
+
+    // stops from which the target is reached, offset is added to the arrival at the stop
+    std::vector<StopOffset> egress;
+
+    // departure time from the source
+    size_t startTime = 0;
+
+    // max number of trips used in the search
+    size_t maxTrips = DEFAULT_MAX_TRIPS;
+
+    // deadline and work budget of the search (no limits by default)
+    SearchLimits limits{};
+
+    static constexpr size_t DEFAULT_MAX_TRIPS = 5;
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "QueryLog.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+// bytes of the file header (magic, version) and of the frame of a record (size, checksum)
+constexpr size_t HEADER_SIZE = 8;
+constexpr size_t FRAME_SIZE = 8;
+
+// the fixed fields and two names of the maximal length
+constexpr size_t MAX_RECORD_SIZE = 32 + 2 * (2 + UINT16_MAX);
+
+template<typename T>
+void appendValue(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool readValue(const char*& in, const char* end, T& value) {
+    if (end - in < static_cast<std::ptrdiff_t>(sizeof(T))) return false;
+    std::copy_n(in, sizeof(T), reinterpret_cast<char*>(&value));
+    in += sizeof(T);
+    return true;
+}
+
+// the names are short, their length is stored in 2 bytes
+void appendString(std::string& out, const std::string& s) {
+    auto&& size = static_cast<uint16_t>(std::min<size_t>(s.size(), UINT16_MAX));
+    appendValue(out, size);
+    out.append(s.data(), size);
+}
+
+bool readString(const char*& in, const char* end, std::string& s) {
+    uint16_t size;
+    if (!readValue(in, end, size) || end - in < size) return false;
+    s.assign(in, size);
+    in += size;
+    return true;
+}
+
+// FNV-1a
+uint32_t getChecksum(const char* data, size_t size) {
+    uint32_t hash = 0x811c9dc5;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 0x01000193;
+    }
+    return hash;
+}
+
+std::string getHeader(uint32_t magic, uint32_t version) {
+    std::string header;
+    appendValue(header, magic);
+    appendValue(header, version);
+    return header;
+}
+
+// the record with its frame
+void serialize(const QueryRecord& record, std::string& out) {
+    out.assign(FRAME_SIZE, '\0');
+    appendValue(out, record.startTime);
+    appendValue(out, static_cast<uint8_t>(record.engine));
+    appendValue(out, record.maxTrips);
+    appendValue(out, record.maxWork);
+    appendValue(out, record.timeout);
+    appendValue(out, record.arrivalTime);
+    appendValue(out, record.trips);
+    appendValue(out, static_cast<uint8_t>(record.complete));
+    appendValue(out, record.duration);
+    appendString(out, record.startName);
+    appendString(out, record.endName);
+
+    auto&& size = static_cast<uint32_t>(out.size() - FRAME_SIZE);
+    auto&& checksum = getChecksum(out.data() + FRAME_SIZE, size);
+    std::memcpy(out.data(), &size, sizeof(size));
+    std::memcpy(out.data() + sizeof(size), &checksum, sizeof(checksum));
+}
+
+// the data of a record (without the frame), all of them have to be used
+bool deserialize(const char* in, const char* end, QueryRecord& record) {
+    uint8_t engine = 0, complete = 0;
+    bool ok = readValue(in, end, record.startTime) && readValue(in, end, engine) &&
+        readValue(in, end, record.maxTrips) && readValue(in, end, record.maxWork) &&
+        readValue(in, end, record.timeout) && readValue(in, end, record.arrivalTime) &&
+        readValue(in, end, record.trips) && readValue(in, end, complete) && readValue(in, end, record.duration) &&
+        readString(in, end, record.startName) && readString(in, end, record.endName) && in == end;
+    record.engine = static_cast<EngineType>(engine);
+    record.complete = complete != 0;
+    return ok;
+}
+
+bool writeAll(int fd, const char* data, size_t size) {
+    while (size != 0) {
+        auto&& written = ::write(fd, data, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// create the log with the header under a temporary name and link it, so other processes see it complete,
+// true also if another process created it first
+bool createLog(const std::string& filename, const std::string& header) {
+    auto&& temporary = filename + ".tmp" + std::to_string(getpid());
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    bool ok = fd >= 0 && writeAll(fd, header.data(), header.size());
+    if (fd >= 0) ok = ::close(fd) == 0 && ok;
+    ok = ok && (link(temporary.c_str(), filename.c_str()) == 0 || errno == EEXIST);
+    unlink(temporary.c_str());
+    return ok;
+}
+
+}
+
+void QueryRecord::setResult(const Journey& journey, std::chrono::nanoseconds searchTime) {
+    arrivalTime = journey.found() ? static_cast<uint32_t>(journey.getArrivalTime()) : UINT32_MAX;
+    trips = static_cast<uint8_t>(journey.size());
+    complete = journey.isComplete();
+    duration = static_cast<uint64_t>(searchTime.count());
+}
+
+QueryLog::~QueryLog() {
+    close();
+}
+
+void QueryLog::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+bool QueryLog::open(const std::string& filename) {
+    close();
+    auto&& header = getHeader(MAGIC, VERSION);
+    fd_ = ::open(filename.c_str(), O_RDWR | O_APPEND);
+    if (fd_ < 0 && errno == ENOENT && createLog(filename, header)) {
+        fd_ = ::open(filename.c_str(), O_RDWR | O_APPEND);
+    }
+    if (fd_ < 0) {
+        std::cout << "Can't write " << filename << '\n';
+        return false;
+    }
+
+    // the records are appended only to a log of this version
+    std::string existing(HEADER_SIZE, '\0');
+    if (pread(fd_, existing.data(), existing.size(), 0) != static_cast<ssize_t>(existing.size()) ||
+        existing != header) {
+        std::cout << "Can't append to " << filename << ", it isn't a query log of this version\n";
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool QueryLog::write(const QueryRecord& record) {
+    serialize(record, buffer_);
+    return fd_ >= 0 && writeAll(fd_, buffer_.data(), buffer_.size());
+}
+
+bool QueryLog::read(const std::string& filename, std::vector<QueryRecord>& records) {
+    std::ifstream file{filename, std::ios::binary};
+    std::string data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    if (data.compare(0, HEADER_SIZE, getHeader(MAGIC, VERSION)) != 0) {
+        std::cout << "Can't read query log " << filename << '\n';
+        return false;
+    }
+
+    // a damaged frame can't tell where the next record starts, so it is searched byte by byte
+    const char* in = data.data() + HEADER_SIZE;
+    const char* end = data.data() + data.size();
+    size_t skipped = 0;
+    while (in < end) {
+        const char* next = in;
+        uint32_t size = 0, checksum = 0;
+        QueryRecord record;
+        if (readValue(next, end, size) && readValue(next, end, checksum) && size <= MAX_RECORD_SIZE &&
+            end - next >= size && getChecksum(next, size) == checksum && deserialize(next, next + size, record)) {
+            records.emplace_back(std::move(record));
+            in = next + size;
+        }
+        else {
+            ++in;
+            ++skipped;
+        }
+    }
+    if (skipped != 0) {
+        std::cout << "Skipped " << skipped << " bytes of damaged or incomplete records in " << filename << '\n';
+    }
+    return true;
+}
+
+bool QueryLog::save(const std::string& filename, const std::vector<QueryRecord>& records) {
+    std::ofstream out{filename, std::ios::binary | std::ios::trunc};
+    std::string buffer = getHeader(MAGIC, VERSION);
+    out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    for (auto&& record: records) {
+        serialize(record, buffer);
+        out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    }
+    out.close();
+    if (out.fail()) std::cout << "Can't write " << filename << '\n';
+    return !out.fail();
+}
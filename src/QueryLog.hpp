@@ -0,0 +1,72 @@
+#ifndef QUERYLOG_HPP_
+#define QUERYLOG_HPP_
+
+#include "SearchEngine.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// one logged query - what was asked, how it was searched and what the search found
+struct QueryRecord {
+    // names (or "lat,lon") of the source and the target as entered
+    std::string startName;
+    std::string endName;
+    uint32_t startTime = 0;
+
+    // options of the search
+    EngineType engine = EngineType::Raptor;
+    uint8_t maxTrips = Query::DEFAULT_MAX_TRIPS;
+    uint64_t maxWork = UINT64_MAX;
+    uint32_t timeout = 0; // milliseconds, 0 without a deadline
+
+    // result of the search
+    uint32_t arrivalTime = UINT32_MAX;
+    uint8_t trips = 0;
+    bool complete = true;
+    uint64_t duration = 0; // nanoseconds
+
+    void setResult(const Journey& journey, std::chrono::nanoseconds searchTime);
+};
+
+// compact binary log of queries, records are appended to the file one by one
+// so that several processes can log into the same file
+//
+// file (native byte order): magic "QLOG", version (u32), then the records, every one framed by the size
+// of its data (u32) and their FNV-1a checksum (u32), so a damaged record can be found and skipped
+class QueryLog {
+public:
+    QueryLog() = default;
+    ~QueryLog();
+
+    QueryLog(const QueryLog&) = delete;
+    QueryLog& operator=(const QueryLog&) = delete;
+
+    // open the log for appending, a new file is created with the header (atomically, another process
+    // may be creating it too), returns false if an existing file isn't a query log of this version
+    bool open(const std::string& filename);
+
+    // append the record (one write of the whole record)
+    bool write(const QueryRecord& record);
+
+    // read all records of the log, returns false if it isn't a query log,
+    // damaged records and an incomplete last record (the logging process was killed) are skipped
+    static bool read(const std::string& filename, std::vector<QueryRecord>& records);
+
+    // write all records into a new log
+    static bool save(const std::string& filename, const std::vector<QueryRecord>& records);
+
+private:
+    void close();
+
+    int fd_ = -1;
+
+    // serialized record
+    std::string buffer_;
+
+    static constexpr uint32_t MAGIC = 0x474F4C51; // "QLOG"
+    static constexpr uint32_t VERSION = 2;
+};
+
+#endif
@@ -1,7 +1,8 @@
 #include "Raptor.hpp"
+#include "JourneyFormatter.hpp"
 
 #include <algorithm>
-#include <unordered_map>
+#include <array>
 #include <iostream>
 #include <sstream>
 
@@ -12,32 +13,9 @@
 //#define DEBUG_PRINT_CONNECTION_
 
 std::string Raptor::toTimeString(size_t timeInSeconds, bool leadingZero, bool roundSeconds, bool roundNextDay) {
-    if (timeInSeconds == SIZE_MAX) return "inf";
-
-    if (roundNextDay) {
-        timeInSeconds %= HOUR_SECONDS * 24;
-    }
-
-    if (roundSeconds) {
-        auto seconds = timeInSeconds % MINUTE_SECONDS;
-        if (seconds >= 30) { // round up seconds
-            timeInSeconds += MINUTE_SECONDS - seconds;
-        }
-    }
-
-    std::string time;
-    auto&& hours = std::to_string(timeInSeconds / HOUR_SECONDS);
-    time += hours.size() == 2 ? hours: (leadingZero ? "0" : "") + hours;
-    timeInSeconds %= HOUR_SECONDS;
-    auto&& minutes = std::to_string(timeInSeconds / MINUTE_SECONDS);
-    time += ":" + ((minutes.size() == 2) ? minutes: "0" + minutes);
-
-    if (roundSeconds) return time;
-
-    timeInSeconds %= MINUTE_SECONDS;
-    auto&& seconds = std::to_string(timeInSeconds);
-    time += ":" + (seconds.size() == 2 ? seconds : "0" + seconds);
-    return time;
+    char buffer[JourneyFormatter::MAX_TIME_LENGTH];
+    auto&& last = JourneyFormatter::writeTime(buffer, timeInSeconds, leadingZero, roundSeconds, roundNextDay);
+    return {buffer, last};
 }
 
 [[maybe_unused]]
@@ -53,252 +31,286 @@ size_t Raptor::toSeconds(const std::string& timeString) {
     return seconds;
 }
 
-void Raptor::initialization() {
-    // initialize with inf
-    for (auto&& [_, stop]: timetable_.getStops()) {
-        auto&& arr = stop.getArrTimesKTrips();
-        arr.resize(numberOfTrips_ + 1);
-        std::fill_n(arr.begin(), numberOfTrips_ + 1, SIZE_MAX);
-    }
-
-    start_.getArrTimesKTrips()[0] = startTime_;
-    start_.getEarliestTime() = startTime_;
+Raptor::Raptor(Timetable& t, const Query& query)
+    : SearchEngine(t, query, t.getSchedule()), numberOfTrips_(std::clamp<size_t>(query.maxTrips, 1, MAX_TRIPS)),
+      startTime_(query.startTime), stopCount_(t.getStopCount()) {}
 
-    // first stop is the artificial source, mark real stops
-    for (auto&& to: timetable_.getTransfers()[&start_]) {
-        to->getArrTimesKTrips()[0] = startTime_;
-        to->getEarliestTime() = startTime_;
-        //transfer
-        to->getTransferFrom() = &start_;
-        to->mark();
+void Raptor::initialization(size_t rounds, bool withParents) {
+    // initialize with inf
+    rounds_ = rounds;
+    labels_.assign(rounds * stopCount_, SIZE_MAX);
+    earliestTimes_.assign(stopCount_, SIZE_MAX);
+    if (withParents) parents_.resize(rounds * stopCount_);
+    else parents_.clear();
+    marked_.assign(stopCount_, false);
+    markedStops_.clear();
+
+    arrivalTime_ = SIZE_MAX;
+    targetStop_ = nullptr;
+    startLimits();
+
+    // stops reachable from the source, the journey starts there
+    for (auto&& [stop, offset]: query_.access) {
+        size_t time = startTime_ + offset;
+        auto&& index = stop->getId() * rounds;
+        if (time < labels_[index]) {
+            labels_[index] = time;
+            earliestTimes_[stop->getId()] = time;
+            if (withParents) parents_[index] = {};
+            mark(stop);
+        }
     }
 }
 
-void Raptor::updateRoutesToScan(std::unordered_map<Route*, Stop*>& routesToScan) {
-    routesToScan.clear();
-    for (auto&& stop: timetable_.getMarkedStops()) {
+void Raptor::updateRoutesToScan() {
+    routesToScan_.clear();
+    for (auto&& stop: markedStops_) {
 #ifdef DEBUG_UPDATE_ROUTES_TO_SCAN_
-        std::cout << "Marked: " << stop->getId() << ' ' << stop->getName() << std::endl;
+        std::cout << "Marked: " << stop->getId() << ' ' << timetable_.getName(*stop) << std::endl;
 #endif
         for (auto&& route: stop->getRoutes()) {
 #ifdef DEBUG_UPDATE_ROUTES_TO_SCAN_
-            std::cout << "  Route: " << route->getId() << ' ' << route->getName() << std::endl;
+            std::cout << "  Route: " << route->getId() << ' ' << timetable_.getName(*route) << std::endl;
 #endif
-            if (auto&& it = routesToScan.find(route); it != routesToScan.end()) {
+            if (auto&& it = routesToScan_.find(route); it != routesToScan_.end()) {
                 if (auto&& [_, firstStop] = *it; route->isEarlier(stop, firstStop)) {
                     firstStop = stop;
                 }
             }
             else {
-                routesToScan.emplace(route, stop);
+                routesToScan_.emplace(route, stop);
             }
         }
-        stop->unmark();
+        marked_[stop->getId()] = false;
     }
+    markedStops_.clear();
 }
 
-void Raptor::scanRoutes(std::unordered_map<Route*, Stop*>& routesToScan, size_t k) {
-    for (auto&& [route, firstStop]: routesToScan) {
+template<size_t K, bool WithParents>
+void Raptor::scanRoutes(size_t k) {
+    for (auto&& [route, firstStop]: routesToScan_) {
+        // the labels set so far stay valid, the search just won't improve them
+        if (stopSearch()) break;
 #ifdef DEBUG_SCAN_ROUTES_
-        std::cout << "\nScanning route: " << route->getId() << ' ' << route->getName() << " from: "
-            << firstStop->getId() << ' ' << firstStop->getName() << '\n';
+        std::cout << "\nScanning route: " << route->getId() << ' ' << timetable_.getName(*route) << " from: "
+            << firstStop->getId() << ' ' << timetable_.getName(*firstStop) << '\n';
 #endif
-        Trip* currentTrip = nullptr;
-        auto&& routeStops = route->getStops();
-        for (size_t i = route->getStopIndex(firstStop); i < routeStops.size(); ++i) {
-            auto&& stop = routeStops[i];
+        // every lane is scanned on its own, the trips of a lane don't overtake each other
+        auto&& routeTrips = schedule_->getTrips(*route);
+        for (size_t lane = 0; lane < routeTrips.getLaneCount(); ++lane) {
+            scanLane<K, WithParents>(k, *route, route->getStopIndex(firstStop), routeTrips.getTrips(lane),
+                                     routeTrips.getTimes(lane));
+        }
+    }
+}
+
+template<size_t K, bool WithParents>
+void Raptor::scanLane(size_t k, const Route& route, size_t firstIndex, std::span<Trip* const> trips,
+                      std::span<const TripTimes> tripTimes) {
+    Trip* currentTrip = nullptr;
+
+    // times of currentTrip, read from the trip times of the lane
+    const TripTimes* currentTimes = nullptr;
+
+    // stop at which currentTrip was boarded and its index
+    Stop* boardingStop = nullptr;
+    uint32_t boardingIndex = 0;
+
+    auto&& routeStops = route.getStops();
+    for (size_t i = firstIndex; i < routeStops.size(); ++i) {
+        auto&& stop = routeStops[i];
+        auto&& id = stop->getId();
 #ifdef DEBUG_SCAN_ROUTES_
-            std::cout << "  Stop: " << stop->getId() << ' ' << stop->getName() << '\n';
+        std::cout << "  Stop: " << id << ' ' << timetable_.getName(*stop) << '\n';
 #endif
-            if (currentTrip != nullptr) {
+        if (currentTrip != nullptr) {
 
-                // target pruning
-                auto earliestArrTime = std::min(stop->getEarliestTime(), end_.getEarliestTime());
+            // target pruning
+            auto earliestArrTime = std::min(earliestTimes_[id], arrivalTime_);
 #ifdef DEBUG_SCAN_ROUTES_
-                std::cout << " BestTillNow: " << Raptor::toTimeString(stop->getEarliestTime()) <<
-                          " currArr: " << Raptor::toTimeString(currentTrip->getArrivalTimes()[i]) << ' '
-                          << currentTrip->getRoute()->getName() << '\n';
+            std::cout << " BestTillNow: " << Raptor::toTimeString(earliestTimes_[id]) <<
+                      " currArr: " << Raptor::toTimeString(currentTimes->getArrivalTime(i)) << ' '
+                      << timetable_.getName(*currentTrip->getRoute()) << '\n';
 #endif
-                if (size_t currArrTime = currentTrip->getArrivalTimes()[i]; currArrTime < earliestArrTime) {
-                    stop->getArrTimesKTrips()[k] = currArrTime;
-                    stop->getEarliestTime() = currArrTime;
-                    stop->mark();
-
-                    // earliest trip
-                    stop->getEarliestTrip() = currentTrip;
-
-                    // earliest trip in the k-th iteration
-                    stop->getEarliestTrips().insert_or_assign(k, currentTrip);
+            if (size_t currArrTime = currentTimes->getArrivalTime(i); currArrTime < earliestArrTime) {
+                labels_[getIndex<K>(id, k)] = currArrTime;
+                earliestTimes_[id] = currArrTime;
+                mark(stop);
+
+                // remember how the stop was reached in the k-th iteration
+                if constexpr (WithParents) {
+                    parents_[getIndex<K>(id, k)] = {currentTrip, boardingStop, boardingIndex,
+                                                    static_cast<uint32_t>(i)};
                 }
             }
+        }
 
-            size_t currentTime = stop->getArrTimesKTrips()[k - 1];
-
-            // avoid overflow
-            if (currentTime + changeTime_ >= currentTime) {
-                // don't add changeTime_ in the first iteration
-                currentTime += k > 1 ? changeTime_ : 0;
-            }
-
-            auto&& trips = route->getTrips();
-            auto isBefore = [i](auto&& trip, size_t time){
-                return time > trip->getDepartureTimes()[i];
-            };
-
-            // find the first trip that we can take at the currentTime
-            auto it = std::lower_bound(trips.begin(), trips.end(), currentTime, isBefore);
-
-            if (it != trips.end() &&
-                (currentTrip == nullptr ||
-                (*it)->getDepartureTimes()[i] < currentTrip->getDepartureTimes()[i]))
-            {
-                currentTrip = *it;
+        size_t currentTime = labels_[getIndex<K>(id, k - 1)];
 
-                // set the boarding stop of the current trip
-                // only used for the connection reconstruction
-                auto&& boardingStop = currentTrip->getBoardingStop();
-                if (boardingStop == nullptr ||
-                    (stop->getTransferFrom() == &start_ && route->isEarlier(stop, boardingStop))) {
+        // avoid overflow
+        if (currentTime + changeTime_ >= currentTime) {
+            // don't add changeTime_ in the first iteration
+            currentTime += k > 1 ? changeTime_ : 0;
+        }
 
-                    currentTrip->getBoardingStop() = stop;
+        auto isBefore = [i](auto&& times, size_t time){
+            return time > times.getDepartureTime(i);
+        };
+
+        // find the first trip that we can take at the currentTime
+        auto it = std::lower_bound(tripTimes.begin(), tripTimes.end(), currentTime, isBefore);
+
+        if (it != tripTimes.end() &&
+            (currentTrip == nullptr ||
+            it->getDepartureTime(i) < currentTimes->getDepartureTime(i)))
+        {
+            currentTrip = trips[it - tripTimes.begin()];
+            currentTimes = &*it;
+            boardingStop = stop;
+            boardingIndex = static_cast<uint32_t>(i);
 #ifdef DEBUG_SCAN_ROUTES_
-                    std::cout << " BOARDING" << std::endl;
-                    std::cout << " BestTillNow: " << Raptor::toTimeString(stop->getEarliestTime()) <<
-                              " currArr: " << Raptor::toTimeString(currentTrip->getArrivalTimes()[i]) << ' '
-                              << currentTrip->getRoute()->getName() << " currDep: " <<
-                              Raptor::toTimeString(currentTrip->getDepartureTimes()[i]) << '\n';
+            std::cout << " BOARDING" << std::endl;
+            std::cout << " BestTillNow: " << Raptor::toTimeString(earliestTimes_[id]) <<
+                      " currArr: " << Raptor::toTimeString(currentTimes->getArrivalTime(i)) << ' '
+                      << timetable_.getName(*currentTrip->getRoute()) << " currDep: " <<
+                      Raptor::toTimeString(currentTimes->getDepartureTime(i)) << '\n';
 #endif
-                }
-            }
         }
     }
 }
 
+template<size_t K, bool WithParents>
 void Raptor::scanTransfers(size_t k) {
-    for (auto&& from: timetable_.getMarkedStops()) {
+    auto&& transfers = timetable_.getTransfers();
+
+    // only the stops marked by scanRoutes, the stops marked here are appended
+    for (size_t m = 0, markedCount = markedStops_.size(); m < markedCount; ++m) {
+        Stop* from = markedStops_[m]; // copy, marking may reallocate markedStops_
 #ifdef DEBUG_SCAN_TRANSFERS_
-        std::cout << "Transfers from: " << from->getId() << ' ' << from->getName() << '\n';
+        std::cout << "Transfers from: " << from->getId() << ' ' << timetable_.getName(*from) << '\n';
 #endif
-        for (auto&& to: timetable_.getTransfers()[from]) {
-            // transfer: from -> to
-            // in the last iteration, change transfers only to the artificial end/destination stop
-            if (k < numberOfTrips_ || to->isArtificial()) {
+        auto&& it = transfers.find(from);
+        if (it == transfers.end()) continue;
 
-                size_t currentTime = from->getArrTimesKTrips()[k];
-
-                // avoid overflow
-                if (currentTime + transferTime_ >= currentTime) {
-                    currentTime += transferTime_;
-                }
+        for (auto&& to: it->second) {
+            // transfer: from -> to
+            size_t currentTime = labels_[getIndex<K>(from->getId(), k)];
 
-                to->getArrTimesKTrips()[k] = std::min(to->getArrTimesKTrips()[k], currentTime);
+            // avoid overflow
+            if (currentTime + transferTime_ >= currentTime) {
+                currentTime += transferTime_;
+            }
 
-                if (to->getArrTimesKTrips()[k] < to->getEarliestTime()) {
-                    to->getEarliestTime() = to->getArrTimesKTrips()[k];
-                    to->mark();
-                    to->getTransferFrom() = from;
-                }
+            // labels that don't improve the earliest time are dominated,
+            // they are skipped so that every set label has its parent record
+            if (auto&& id = to->getId(); currentTime < std::min(earliestTimes_[id], arrivalTime_)) {
+                labels_[getIndex<K>(id, k)] = currentTime;
+                earliestTimes_[id] = currentTime;
+                mark(to);
+                if constexpr (WithParents) parents_[getIndex<K>(id, k)] = {nullptr, from};
+            }
 #ifdef DEBUG_SCAN_TRANSFERS_
-                std::cout << "  to: " << to->getId() << ' ' << to->getName() << '\n';
+            std::cout << "  to: " << to->getId() << ' ' << timetable_.getName(*to) << '\n';
 #endif
-            }
+        }
+    }
+}
+
+template<size_t K>
+void Raptor::scanEgress(size_t k) {
+    for (auto&& [stop, offset]: query_.egress) {
+        // the stop was reached (improved) in this iteration
+        if (size_t time = labels_[getIndex<K>(stop->getId(), k)]; time != SIZE_MAX && time + offset < arrivalTime_) {
+            arrivalTime_ = time + offset;
+            targetStop_ = stop;
+            targetRound_ = k;
         }
     }
 }
 
 [[maybe_unused]]
 void Raptor::setEarliestTimes(size_t k) {
-    for (auto&& [_, stop]: timetable_.getStops()) {
-        auto&& arr = stop.getArrTimesKTrips();
-        arr[k] = arr[k - 1];
-    }
+    for (size_t id = 0; id < stopCount_; ++id) labels_[id * rounds_ + k] = labels_[id * rounds_ + k - 1];
 }
 
-void Raptor::raptor() {
-    initialization();
-    std::unordered_map<Route*, Stop*> routesToScan;
-	
-	for (size_t k = 1; k < numberOfTrips_ + 1; ++k) {
+template<typename Phase>
+void Raptor::profile(std::chrono::nanoseconds& time, uint64_t& counter, Phase&& phase) {
+    uint64_t counterStart = profile_->readCounter ? profile_->readCounter() : 0;
+    auto&& start = std::chrono::steady_clock::now();
+    phase();
+    time += std::chrono::steady_clock::now() - start;
+    if (profile_->readCounter) counter += profile_->readCounter() - counterStart;
+}
+
+template<size_t K, bool WithParents>
+void Raptor::run() {
+    initialization(K + 1, WithParents);
+
+    // K is known at compile time, so the rows of the labels have a constant length;
+    // the iterations aren't unrolled - with k as a template parameter of the scans the search wasn't faster
+    // (EngineBenchmark, K = 2, 5 and 8), and every K instantiated its scans K more times
+	for (size_t k = 1; k < K + 1; ++k) {
 #ifdef DEBUG_RAPTOR_
         std::cout << "Iteration " << k << std::endl;
 #endif
         //setEarliestTimes(k); // not needed in this version of the algorithm
-        updateRoutesToScan(routesToScan);
-        scanRoutes(routesToScan, k);
-        scanTransfers(k);
-		if (timetable_.getMarkedStops().empty()) break;
-	}
-}
-
-[[nodiscard]]
-std::vector<std::pair<Trip*, Stop*>> Raptor::getConnection() const {
-    std::vector<std::pair<Trip*, Stop*>> legs;
-    auto stop = end_.getTransferFrom();
-
-    for (size_t k = numberOfTrips_; k > 0; --k) {
-        Trip* trip = nullptr;
-
-        // get the earliest arriving trip at stop in iteration <= k
-        for (auto&& [iteration, t]: stop->getEarliestTrips()) {
-            if (iteration <= k) {
-                if (trip == nullptr ||
-                    trip->getArrivalTimes()[trip->getStopIndex(stop)] >
-                    t->getArrivalTimes()[t->getStopIndex(stop)])
-                {
-                    trip = t;
-                }
+        if (profile_ != nullptr) {
+            profile(profile_->routes, profile_->routesCounter, [this, k] {
+                updateRoutesToScan();
+                scanRoutes<K, WithParents>(k);
+            });
+            if (!isInterrupted()) {
+                profile(profile_->transfers, profile_->transfersCounter, [this, k] {
+                    scanTransfers<K, WithParents>(k);
+                });
             }
         }
-        // trip and it's departure stop
-        legs.emplace_back(trip, stop);
-
-        auto&& boardingStop = trip->getBoardingStop();
-
-        if (boardingStop->getTransferFrom() != nullptr) {
-            stop = boardingStop->getTransferFrom();
+        else {
+            updateRoutesToScan();
+            scanRoutes<K, WithParents>(k);
+            if (!isInterrupted()) scanTransfers<K, WithParents>(k);
         }
-        else stop = boardingStop;
-
-        // if start stop was reached
-        if (stop->isArtificial()) break;
-    }
+        scanEgress<K>(k);
+		if (markedStops_.empty() || isInterrupted() || (k < K && checkLimits())) break;
+	}
+}
 
-    // legs are filled from end to start, reverse the order
-    std::ranges::reverse(legs);
+template<size_t... Ks>
+Raptor::Kernel Raptor::getKernel(size_t numberOfTrips, bool withParents, std::index_sequence<Ks...>) {
+    static constexpr std::array<Kernel, sizeof...(Ks)> withParentsKernels{&Raptor::run<Ks + 1, true>...};
+    static constexpr std::array<Kernel, sizeof...(Ks)> timesOnlyKernels{&Raptor::run<Ks + 1, false>...};
+    return withParents ? withParentsKernels[numberOfTrips - 1] : timesOnlyKernels[numberOfTrips - 1];
+}
 
-    return legs;
+void Raptor::raptor(bool timesOnly) {
+    auto&& kernel = getKernel(numberOfTrips_, !timesOnly, std::make_index_sequence<MAX_TRIPS>{});
+    (this->*kernel)();
 }
 
-void Raptor::printConnection(bool pretty) const {
-    if (end_.getEarliestTime() == SIZE_MAX) {
-        std::cout << "No connection found!\n";
-        //std::cout << "No connection found! Try choosing more transfers.\n";
-        return;
-    }
-    for (auto&& [trip, end]: getConnection()) {
-        auto&& route = trip->getRoute();
-        size_t endIndex = route->getStopIndex(end);
-
-        auto&& start = trip->getBoardingStop();
-        size_t startIndex = route->getStopIndex(start);
-
-        if (pretty) {
-            // departure
-            std::cout << Raptor::toTimeString(trip->getDepartureTimes()[startIndex], false, true, true)
-                      << ' ' << start->getName() << " >> ";
-            // arrival
-            std::cout << toTimeString(trip->getArrivalTimes()[endIndex], false, true, true)
-                      << ' ' << end->getName() << ' ' << route->getName() << '\n';
-        }
-        else {
-            // used for debugging
-            std::cout << "Departure: " << start->getId() << ' ' << start->getName() << ' '
-                      << Raptor::toTimeString(trip->getDepartureTimes()[startIndex])
-                      << ' ' << route->getName() << '\n';
-
-            std::cout << "Arrival: " << end->getId() << ' ' << end->getName() << ' '
-                      << Raptor::toTimeString(trip->getArrivalTimes()[endIndex])
-                      << ' ' << route->getName() << '\n';
+Journey Raptor::getJourney() const {
+    Journey journey;
+    journey.setComplete(!isInterrupted());
+    if (targetStop_ == nullptr) return journey;
+    journey.setArrivalTime(arrivalTime_);
+
+    // searching just for the times
+    if (parents_.empty()) return journey;
+
+    // follow the parent records from the destination back to the source,
+    // the stops reachable from the source have no parent
+    size_t k = targetRound_;
+    for (Stop* stop = targetStop_; stop != nullptr;) {
+        auto&& parent = parents_[stop->getId() * rounds_ + k];
+        if (parent.trip != nullptr) {
+            journey.addLeg(createLeg(parent.trip, parent.fromIndex, parent.toIndex));
+
+            // the boarding stop was reached in the previous iteration
+            --k;
         }
+        stop = parent.from;
     }
+
+    // legs are filled from end to start, reverse the order
+    journey.reverse();
+    return journey;
 }
@@ -1,15 +1,41 @@
 #ifndef RAPTOR_HPP_
 #define RAPTOR_HPP_
 
-#include "Timetable.hpp"
+#include "SearchEngine.hpp"
+
+#include <chrono>
+#include <functional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+
+// time (and optionally a hardware counter, e.g. cache misses) spent in the phases of the raptor search,
+// summed over all searches using the profile (see Raptor::setProfile)
+struct RaptorProfile {
+    // updateRoutesToScan and scanRoutes
+    std::chrono::nanoseconds routes{0};
+    uint64_t routesCounter = 0;
+
+    // scanTransfers
+    std::chrono::nanoseconds transfers{0};
+    uint64_t transfersCounter = 0;
+
+    // current value of the counter, not read if empty
+    std::function<uint64_t()> readCounter;
+};
 
-class Raptor {
+class Raptor : public SearchEngine {
 public:
-    Raptor(Timetable& t, Stop& start, Stop& end, size_t startTime)
-        : timetable_(t), start_(start), end_(end), startTime_(startTime) {}
+    // max number of trips supported by the search (query.maxTrips is clamped to 1..MAX_TRIPS)
+    static constexpr size_t MAX_TRIPS = Journey::MAX_LEGS;
+
+    Raptor(Timetable& t, const Query& query);
 
     // run the raptor algorithm (the search)
-    void raptor();
+    // with timesOnly, no parent records are stored - the journey has just the arrival time
+    void raptor(bool timesOnly=false);
+
+    void search() override { raptor(); }
 
     // create human-readable time string from timeInSeconds
     static std::string toTimeString(size_t timeInSeconds, bool leadingZero=false,
@@ -19,39 +45,89 @@ public:
     [[maybe_unused]]
     static size_t toSeconds(const std::string& timeString);
 
-    // print the resulting connection (set pretty=true for the user)
-    void printConnection(bool pretty=false) const;
+    // get the resulting connection - sequence of trips with boarding and exit stops
+    [[nodiscard]]
+    Journey getJourney() const override;
+
+    // the earliest arrival time at the target, SIZE_MAX if it can't be reached
+    [[nodiscard]]
+    size_t getArrivalTime() const { return arrivalTime_; }
+
+    // the earliest arrival time at stop using at most k trips (SIZE_MAX if not improved in the k-th iteration)
+    [[maybe_unused]] [[nodiscard]]
+    size_t getArrivalTime(const Stop& stop, size_t k) const { return labels_[stop.getId() * rounds_ + k]; }
+
+    // the earliest arrival time at stop (overall)
+    [[maybe_unused]] [[nodiscard]]
+    size_t getEarliestTime(const Stop& stop) const { return earliestTimes_[stop.getId()]; }
 
     [[maybe_unused]]
     Timetable& getTimetable() { return timetable_; }
 
+    // measure the phases of the search into profile (nullptr to stop measuring)
+    void setProfile(RaptorProfile* profile) { profile_ = profile; }
+
 private:
+    // search specialized for the number of trips (iterations), the rows of the labels have K + 1 entries,
+    // parent records for the reconstruction are stored only WithParents
+    template<size_t K, bool WithParents>
+    void run();
+
+    using Kernel = void (Raptor::*)();
+
+    // get the search specialized for numberOfTrips
+    template<size_t... Ks>
+    static Kernel getKernel(size_t numberOfTrips, bool withParents, std::index_sequence<Ks...>);
+
     // initialize values for the raptor algorithm
-    void initialization();
+    void initialization(size_t rounds, bool withParents);
 
     // prepare routes that will be scanned in the current iteration
-    void updateRoutesToScan(std::unordered_map<Route*, Stop*>& routesToScan);
+    void updateRoutesToScan();
 
     // traverse all prepared routes in the current iteration
     // the main part of the search
-    void scanRoutes(std::unordered_map<Route*, Stop*>& routesToScan, size_t k);
+    template<size_t K, bool WithParents>
+    void scanRoutes(size_t k);
+
+    // traverse the trips of one lane of route (see RouteTrips) from its firstIndex-th stop
+    template<size_t K, bool WithParents>
+    void scanLane(size_t k, const Route& route, size_t firstIndex, std::span<Trip* const> trips,
+                  std::span<const TripTimes> tripTimes);
 
     // transfers (footpaths) part of the raptor algorithm
+    template<size_t K, bool WithParents>
     void scanTransfers(size_t k);
 
-    // get sequence of trips with corresponding exit stops
-    [[nodiscard]]
-    std::vector<std::pair<Trip*, Stop*>> getConnection() const;
+    // check if the target can be reached from the stops reached in the k-th iteration
+    template<size_t K>
+    void scanEgress(size_t k);
+
+    // run phase of the search and add its time (and counter) to the profile
+    template<typename Phase>
+    void profile(std::chrono::nanoseconds& time, uint64_t& counter, Phase&& phase);
 
     // set upper bound for earliest arrival times in the k-th iteration
     [[maybe_unused]]
     void setEarliestTimes(size_t k);
 
+    // mark stop improved in the current iteration
+    void mark(Stop* stop) {
+        if (marked_[stop->getId()]) return;
+        marked_[stop->getId()] = true;
+        markedStops_.emplace_back(stop);
+    }
+
+    // index of the label (and the parent) of the stop with id in the k-th iteration,
+    // the rows of the search with K trips are K + 1 entries long
+    template<size_t K>
+    static size_t getIndex(size_t id, size_t k) { return id * (K + 1) + k; }
+
     static constexpr size_t HOUR_SECONDS = 3600;
     static constexpr size_t MINUTE_SECONDS = 60;
 
     // max number of trips used in the search
-    const size_t numberOfTrips_ = 5;
+    const size_t numberOfTrips_;
 
     const size_t changeTime_ = 30; // change trip at the exact same stop
 
@@ -59,13 +135,38 @@ private:
     const size_t transferTime_ = 120; // transfer/walk to another stop
 
     const size_t startTime_;
-    Timetable& timetable_;
+    const size_t stopCount_;
+
+    // entries in the row of a stop (number of trips + 1)
+    size_t rounds_ = 0;
+
+    // row of every stop (stop-major) holds its earliest arrival times in all iterations,
+    // k-th entry in the k-th iteration (using at most k trips), so a scan reads the label of the previous
+    // iteration next to the one it writes
+    std::vector<size_t> labels_;
+
+    // the earliest arrival time at every stop (overall)
+    std::vector<size_t> earliestTimes_;
+
+    // rows like labels_, describe how the stops were reached in the iterations,
+    // valid only where labels_ are set (empty if searching just for the times)
+    std::vector<ParentRecord> parents_;
+
+    // stops improved in the current iteration
+    std::vector<bool> marked_;
+    std::vector<Stop*> markedStops_;
+
+    // routes serving the marked stops and their first marked stop
+    std::unordered_map<Route*, Stop*> routesToScan_;
+
+    // the earliest arrival time at the target
+    size_t arrivalTime_ = SIZE_MAX;
 
-    // source/start stop
-    Stop& start_;
+    // stop from which the target was reached at arrivalTime_ and the iteration
+    Stop* targetStop_ = nullptr;
+    size_t targetRound_ = 0;
 
-    // end/destination stop
-    Stop& end_;
+    RaptorProfile* profile_ = nullptr;
 };
 
 #endif
@@ -9,4 +9,17 @@ bool Route::isEarlier(const Stop* s1, const Stop* s2) const {
 size_t Route::getStopIndex(const Stop* s) const {
     auto&& it = std::ranges::find(stops_, s);
     return it - stops_.cbegin();
-}
\ No newline at end of file
+}
+
+void Route::updateTripTimes() {
+    // copied first, the trips may point into tripTimes_ or into the times of another route
+    std::vector<TripTimes> times;
+    times.reserve(trips_.size());
+    for (auto&& trip: trips_) times.emplace_back(trip->getTimes() != nullptr ? *trip->getTimes() : TripTimes{});
+    tripTimes_.assign(times.begin(), times.end());
+    for (size_t t = 0; t < trips_.size(); ++t) trips_[t]->setTimes(&tripTimes_[t]);
+}
+
+size_t Route::getTripIndex(const Trip& trip) const {
+    return static_cast<size_t>(trip.getTimes() - tripTimes_.data());
+}
@@ -0,0 +1,41 @@
+#include "Schedule.hpp"
+
+#include <algorithm>
+
+RouteTrips::RouteTrips(const Route& route) :
+    trips_(route.getTrips()), times_(route.getTripTimes()),
+    laneEnds_{static_cast<uint32_t>(route.getTrips().size())} {}
+
+RouteTrips::RouteTrips(std::vector<Trip*> trips, std::vector<TripTimes> times, std::vector<uint32_t> laneEnds,
+                       std::vector<uint32_t> positions) :
+    delayedTrips_(std::move(trips)), delayedTimes_(std::move(times)), trips_(delayedTrips_), times_(delayedTimes_),
+    laneEnds_(std::move(laneEnds)), positions_(std::move(positions)) {}
+
+size_t RouteTrips::getLane(uint32_t position) const {
+    if (laneEnds_.size() == 1) return 0;
+    return static_cast<size_t>(std::ranges::upper_bound(laneEnds_, position) - laneEnds_.begin());
+}
+
+size_t RouteTrips::getMemoryUsage() const {
+    return sizeof(RouteTrips) + delayedTrips_.capacity() * sizeof(Trip*) +
+        delayedTimes_.capacity() * sizeof(TripTimes) + laneEnds_.capacity() * sizeof(uint32_t) +
+        positions_.capacity() * sizeof(uint32_t);
+}
+
+Schedule::Schedule(std::vector<std::shared_ptr<const RouteTrips>> routes) : routes_(std::move(routes)) {
+    delayed_ = std::ranges::any_of(routes_, [](auto&& trips) { return trips != nullptr && trips->isDelayed(); });
+}
+
+const TripTimes& Schedule::getTimes(const Trip& trip) const {
+    auto&& route = *trip.getRoute();
+    auto&& trips = getTrips(route);
+    return trips.getTimes()[trips.getPosition(route.getTripIndex(trip))];
+}
+
+size_t Schedule::getMemoryUsage() const {
+    size_t usage = sizeof(Schedule) + routes_.capacity() * sizeof(std::shared_ptr<const RouteTrips>);
+    for (auto&& trips: routes_) {
+        if (trips != nullptr) usage += trips->getMemoryUsage();
+    }
+    return usage;
+}
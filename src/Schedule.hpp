@@ -0,0 +1,125 @@
+#ifndef SCHEDULE_HPP_
+#define SCHEDULE_HPP_
+
+#include "DataTypes.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+// trips of a route with their current times split into lanes, the trips of a lane are sorted by departure time
+// and none of them overtakes an earlier trip of the lane at any stop (so the first trip of a lane departing
+// late enough is the best one to board), a route without delays has one lane - the arrays of the route
+class RouteTrips {
+public:
+    // the scheduled trips of route in one lane
+    explicit RouteTrips(const Route& route);
+
+    // delayed trips of a route stored lane by lane, laneEnds are the ends of the lanes in trips
+    // and positions map the index of a trip in its route (see Route::getTripIndex) to its position in trips
+    RouteTrips(std::vector<Trip*> trips, std::vector<TripTimes> times, std::vector<uint32_t> laneEnds,
+               std::vector<uint32_t> positions);
+
+    RouteTrips(const RouteTrips&) = delete;
+    RouteTrips& operator=(const RouteTrips&) = delete;
+
+    [[nodiscard]]
+    size_t getLaneCount() const { return laneEnds_.size(); }
+
+    // position of the first trip of lane
+    [[nodiscard]]
+    uint32_t getLaneBegin(size_t lane) const { return lane == 0 ? 0 : laneEnds_[lane - 1]; }
+
+    [[nodiscard]]
+    uint32_t getLaneEnd(size_t lane) const { return laneEnds_[lane]; }
+
+    // lane of the trip at position
+    [[nodiscard]]
+    size_t getLane(uint32_t position) const;
+
+    // trips of lane sorted by departure time
+    [[nodiscard]]
+    std::span<Trip* const> getTrips(size_t lane) const {
+        return trips_.subspan(getLaneBegin(lane), getLaneEnd(lane) - getLaneBegin(lane));
+    }
+
+    // times of the trips of lane, in the order of the trips
+    [[nodiscard]]
+    std::span<const TripTimes> getTimes(size_t lane) const {
+        return times_.subspan(getLaneBegin(lane), getLaneEnd(lane) - getLaneBegin(lane));
+    }
+
+    // trips of all lanes, lane by lane
+    [[nodiscard]]
+    std::span<Trip* const> getTrips() const { return trips_; }
+
+    [[nodiscard]]
+    std::span<const TripTimes> getTimes() const { return times_; }
+
+    // position of the trip with index in its route (see Route::getTripIndex)
+    [[nodiscard]]
+    uint32_t getPosition(size_t index) const {
+        return positions_.empty() ? static_cast<uint32_t>(index) : positions_[index];
+    }
+
+    // true if the times aren't the scheduled times of the route
+    [[nodiscard]]
+    bool isDelayed() const { return !positions_.empty(); }
+
+    // bytes used by the delayed copies of the trips and times
+    [[nodiscard]]
+    size_t getMemoryUsage() const;
+
+private:
+    // arrays of the delayed trips (empty for the scheduled ones)
+    std::vector<Trip*> delayedTrips_;
+    std::vector<TripTimes> delayedTimes_;
+
+    // trips and their times lane by lane, the arrays of the route or the delayed copies
+    std::span<Trip* const> trips_;
+    std::span<const TripTimes> times_;
+
+    // end of every lane in trips_
+    std::vector<uint32_t> laneEnds_;
+
+    // index of a trip in its route -> its position in trips_ (empty for the scheduled trips)
+    std::vector<uint32_t> positions_;
+};
+
+// trips of all routes with their current times as read by the searches, a schedule isn't changed after
+// it's created - Timetable::applyDelays creates a new one, the searches keep using the one they started with
+class Schedule {
+public:
+    // routes indexed by the route id (nullptr for unused ids)
+    explicit Schedule(std::vector<std::shared_ptr<const RouteTrips>> routes);
+
+    Schedule(const Schedule&) = delete;
+    Schedule& operator=(const Schedule&) = delete;
+
+    // trips of route in this schedule
+    [[nodiscard]]
+    const RouteTrips& getTrips(const Route& route) const { return *routes_[route.getId()]; }
+
+    // times of trip in this schedule
+    [[nodiscard]]
+    const TripTimes& getTimes(const Trip& trip) const;
+
+    // route id -> trips of the route, shared with the next schedules if they don't change
+    [[nodiscard]]
+    const std::vector<std::shared_ptr<const RouteTrips>>& getRoutes() const { return routes_; }
+
+    // true if some trip isn't on schedule
+    [[nodiscard]]
+    bool hasDelays() const { return delayed_; }
+
+    // bytes used by the schedule (without the arrays of the routes)
+    [[nodiscard]]
+    size_t getMemoryUsage() const;
+
+private:
+    std::vector<std::shared_ptr<const RouteTrips>> routes_;
+    bool delayed_ = false;
+};
+
+#endif
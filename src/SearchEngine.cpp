@@ -0,0 +1,81 @@
+#include "SearchEngine.hpp"
+#include "JourneyFormatter.hpp"
+#include "Raptor.hpp"
+#include "TripBased.hpp"
+#include "ConnectionScan.hpp"
+
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+namespace {
+
+constexpr std::array<std::pair<EngineType, std::string_view>, 3> ENGINE_NAMES{{
+    {EngineType::Raptor, "raptor"},
+    {EngineType::TripBased, "trip-based"},
+    {EngineType::ConnectionScan, "csa"}
+}};
+
+}
+
+void SearchEngine::printConnection(bool pretty) const {
+    std::array<char, OUTPUT_BUFFER_SIZE> buffer; // NOLINT(cppcoreguidelines-pro-type-member-init)
+    if (auto&& size = JourneyFormatter::writeText(getJourney(), timetable_.getStrings(), buffer, pretty)) {
+        std::cout.write(buffer.data(), static_cast<std::streamsize>(*size));
+    }
+}
+
+void SearchEngine::printJson() const {
+    std::array<char, OUTPUT_BUFFER_SIZE> buffer; // NOLINT(cppcoreguidelines-pro-type-member-init)
+    if (auto&& size = JourneyFormatter::writeJson(getJourney(), timetable_.getStrings(), buffer)) {
+        std::cout.write(buffer.data(), static_cast<std::streamsize>(*size));
+        std::cout << '\n';
+    }
+}
+
+void SearchEngine::startLimits() {
+    // check before the first unit, the search may be cancelled before it started
+    work_ = 0;
+    nextCheck_ = 0;
+    interrupted_ = false;
+}
+
+bool SearchEngine::checkLimits() {
+    auto&& limits = query_.limits;
+    nextCheck_ = work_ + std::min(CHECK_INTERVAL, limits.maxWork - std::min(work_, limits.maxWork));
+    interrupted_ = interrupted_ || work_ >= limits.maxWork ||
+        (limits.cancelled != nullptr && limits.cancelled->load(std::memory_order_relaxed)) ||
+        (limits.deadline != std::chrono::steady_clock::time_point::max() &&
+         std::chrono::steady_clock::now() >= limits.deadline);
+    return interrupted_;
+}
+
+Leg SearchEngine::createLeg(Trip* trip, uint32_t fromIndex, uint32_t toIndex) const {
+    auto&& stops = trip->getRoute()->getStops();
+    auto&& times = schedule_->getTimes(*trip);
+    return {trip, stops[fromIndex], stops[toIndex], fromIndex, toIndex,
+            static_cast<uint32_t>(times.getDepartureTime(fromIndex)),
+            static_cast<uint32_t>(times.getArrivalTime(toIndex))};
+}
+
+std::unique_ptr<SearchEngine> createEngine(EngineType type, Timetable& t, const Query& query) {
+    switch (type) {
+        case EngineType::TripBased: return std::make_unique<TripBased>(t, query);
+        case EngineType::ConnectionScan: return std::make_unique<ConnectionScan>(t, query);
+        default: return std::make_unique<Raptor>(t, query);
+    }
+}
+
+std::optional<EngineType> getEngineType(std::string_view name) {
+    for (auto&& [type, engineName]: ENGINE_NAMES) {
+        if (engineName == name) return type;
+    }
+    return std::nullopt;
+}
+
+std::string_view getEngineName(EngineType type) {
+    for (auto&& [engineType, name]: ENGINE_NAMES) {
+        if (engineType == type) return name;
+    }
+    return {};
+}
@@ -0,0 +1,95 @@
+#ifndef SEARCHENGINE_HPP_
+#define SEARCHENGINE_HPP_
+
+#include "Timetable.hpp"
+#include "Journey.hpp"
+
+#include <memory>
+#include <optional>
+#include <string_view>
+
+// common interface of the earliest arrival searches
+// all engines give the same arrival time and the same number of trips for the same query
+class SearchEngine {
+public:
+    // the search uses schedule for its whole run (a delayed timetable publishes a new one)
+    SearchEngine(Timetable& t, const Query& query, std::shared_ptr<const Schedule> schedule) :
+        timetable_(t), query_(query), schedule_(std::move(schedule)) {}
+
+    virtual ~SearchEngine() = default;
+
+    // run the search
+    virtual void search() = 0;
+
+    // get the resulting connection - sequence of trips with boarding and exit stops
+    [[nodiscard]]
+    virtual Journey getJourney() const = 0;
+
+    // print the resulting connection (set pretty=true for the user)
+    void printConnection(bool pretty=false) const;
+
+    // print the resulting connection as json
+    void printJson() const;
+
+    // true if the last search was stopped by the limits of the query
+    [[nodiscard]]
+    bool isInterrupted() const { return interrupted_; }
+
+protected:
+    // prepare checking the limits of the query (at the beginning of the search)
+    void startLimits();
+
+    // called before every unit of work (scanned route, trip segment or connection),
+    // returns true if the search has to stop, the clock is read only every CHECK_INTERVAL units
+    bool stopSearch() {
+        if (work_ >= nextCheck_ && checkLimits()) return true;
+        ++work_;
+        return false;
+    }
+
+    // check all limits of the query now (e.g. between the rounds), returns true if the search has to stop
+    bool checkLimits();
+
+    // leg riding trip from its fromIndex-th stop to its toIndex-th stop with the times in schedule_
+    [[nodiscard]]
+    Leg createLeg(Trip* trip, uint32_t fromIndex, uint32_t toIndex) const;
+
+    // number of units of work between the checks of the deadline
+    static constexpr size_t CHECK_INTERVAL = 64;
+
+    // size of the stack buffer used for printing the connection
+    static constexpr size_t OUTPUT_BUFFER_SIZE = 4096;
+
+    Timetable& timetable_;
+
+    // source and target stops
+    const Query& query_;
+
+    // trips of the routes with their times
+    const std::shared_ptr<const Schedule> schedule_;
+
+private:
+    // work done in the search and when to check the limits next time
+    size_t work_ = 0;
+    size_t nextCheck_ = 0;
+
+    bool interrupted_ = false;
+};
+
+// available search engines
+enum class EngineType {
+    Raptor,
+    TripBased,      // needs Timetable::computeTripTransfers or Timetable::loadTripTransfers
+    ConnectionScan  // needs Timetable::createConnections
+};
+
+// create engine of type for query
+std::unique_ptr<SearchEngine> createEngine(EngineType type, Timetable& t, const Query& query);
+
+// get engine type by its name (raptor, trip-based, csa)
+std::optional<EngineType> getEngineType(std::string_view name);
+
+// name of the engine type
+std::string_view getEngineName(EngineType type);
+
+#endif
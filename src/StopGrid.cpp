@@ -0,0 +1,115 @@
+#include "StopGrid.hpp"
+#include "Timetable.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <numbers>
+
+std::optional<Coordinates> Coordinates::parse(std::string_view text) {
+    auto&& comma = text.find(',');
+    if (comma == std::string_view::npos) return std::nullopt;
+
+    // parse number surrounded by spaces
+    auto parseNumber = [](std::string_view s) -> std::optional<double> {
+        while (!s.empty() && s.front() == ' ') s.remove_prefix(1);
+        while (!s.empty() && s.back() == ' ') s.remove_suffix(1);
+        double value = 0;
+        auto&& [last, error] = std::from_chars(s.data(), s.data() + s.size(), value);
+        if (s.empty() || error != std::errc{} || last != s.data() + s.size()) return std::nullopt;
+        return value;
+    };
+    auto&& latitude = parseNumber(text.substr(0, comma));
+    auto&& longitude = parseNumber(text.substr(comma + 1));
+    if (!latitude || !longitude || std::abs(*latitude) > 90 || std::abs(*longitude) > 180) return std::nullopt;
+    return Coordinates{*latitude, *longitude};
+}
+
+std::pair<double, double> StopGrid::project(Coordinates point) const {
+    constexpr double toRadians = std::numbers::pi / 180;
+    return {point.longitude * toRadians * longitudeScale_ * EARTH_RADIUS,
+            point.latitude * toRadians * EARTH_RADIUS};
+}
+
+void StopGrid::create(Timetable& timetable) {
+    stops_.clear();
+    cellOffsets_.clear();
+    columns_ = rows_ = 0;
+
+    std::vector<std::pair<Stop*, Coordinates>> located;
+    double latitudeSum = 0;
+    for (auto&& [_, stop]: timetable.getStops()) {
+        if (auto&& coordinates = timetable.getCoordinates(stop)) {
+            located.emplace_back(&stop, *coordinates);
+            latitudeSum += coordinates->latitude;
+        }
+    }
+    if (located.empty()) return;
+
+    longitudeScale_ = std::cos(latitudeSum / static_cast<double>(located.size()) * std::numbers::pi / 180);
+    double maxX = -INFINITY, maxY = -INFINITY;
+    minX_ = minY_ = INFINITY;
+    for (auto&& [stop, coordinates]: located) {
+        auto&& [x, y] = project(coordinates);
+        stops_.push_back({x, y, stop});
+        minX_ = std::min(minX_, x);
+        minY_ = std::min(minY_, y);
+        maxX = std::max(maxX, x);
+        maxY = std::max(maxY, y);
+    }
+
+    // about one stop per cell on average, but no smaller cells than MIN_CELL_SIZE
+    auto&& area = (maxX - minX_) * (maxY - minY_);
+    cellSize_ = std::max(MIN_CELL_SIZE, std::sqrt(area / static_cast<double>(stops_.size())));
+    columns_ = static_cast<size_t>((maxX - minX_) / cellSize_) + 1;
+    rows_ = static_cast<size_t>((maxY - minY_) / cellSize_) + 1;
+
+    auto getCell = [this](const GridStop& s) {
+        return static_cast<size_t>((s.y - minY_) / cellSize_) * columns_ +
+            static_cast<size_t>((s.x - minX_) / cellSize_);
+    };
+    std::ranges::sort(stops_, {}, getCell);
+
+    cellOffsets_.assign(columns_ * rows_ + 1, 0);
+    for (auto&& s: stops_) ++cellOffsets_[getCell(s) + 1];
+    for (size_t cell = 0; cell + 1 < cellOffsets_.size(); ++cell) cellOffsets_[cell + 1] += cellOffsets_[cell];
+}
+
+std::vector<NearbyStop> StopGrid::findNearest(Coordinates point, size_t count, double radius) const {
+    std::vector<NearbyStop> nearest;
+    if (stops_.empty() || count == 0) return nearest;
+
+    // cells overlapping the square around point (clipped to the grid)
+    auto&& [x, y] = project(point);
+    auto getRange = [this, radius](double value, double min, size_t size) {
+        auto&& first = std::floor((value - radius - min) / cellSize_);
+        auto&& last = std::floor((value + radius - min) / cellSize_);
+        auto&& maxIndex = static_cast<double>(size) - 1;
+        return std::pair{static_cast<size_t>(std::clamp(first, 0.0, maxIndex)),
+                         static_cast<size_t>(std::clamp(last, -1.0, maxIndex) + 1)};
+    };
+    auto&& [firstColumn, lastColumn] = getRange(x, minX_, columns_);
+    auto&& [firstRow, lastRow] = getRange(y, minY_, rows_);
+
+    for (size_t row = firstRow; row < lastRow; ++row) {
+        auto&& first = stops_.begin() + cellOffsets_[row * columns_ + firstColumn];
+        auto&& last = stops_.begin() + cellOffsets_[row * columns_ + std::max(firstColumn, lastColumn)];
+        for (auto&& it = first; it < last; ++it) {
+            auto&& distance = std::hypot(it->x - x, it->y - y);
+            if (distance <= radius) {
+                nearest.push_back({it->stop, distance, static_cast<size_t>(std::ceil(distance / WALKING_SPEED))});
+            }
+        }
+    }
+
+    auto&& last = nearest.begin() + static_cast<ptrdiff_t>(std::min(count, nearest.size()));
+    std::partial_sort(nearest.begin(), last, nearest.end(), [](auto&& s1, auto&& s2) {
+        return s1.distance < s2.distance;
+    });
+    nearest.erase(last, nearest.end());
+    return nearest;
+}
+
+size_t StopGrid::getMemoryUsage() const {
+    return stops_.capacity() * sizeof(GridStop) + cellOffsets_.capacity() * sizeof(uint32_t);
+}
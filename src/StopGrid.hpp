@@ -0,0 +1,97 @@
+#ifndef STOPGRID_HPP_
+#define STOPGRID_HPP_
+
+#include "DataTypes.hpp"
+
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class Timetable;
+
+// wgs84 coordinates in degrees
+struct Coordinates {
+    double latitude;
+    double longitude;
+
+    // parse "latitude,longitude" (e.g. 50.0875,14.4214)
+    [[nodiscard]]
+    static std::optional<Coordinates> parse(std::string_view text);
+};
+
+// stop near some coordinates
+struct NearbyStop {
+    Stop* stop;
+
+    // straight-line distance in meters
+    double distance;
+
+    // time in seconds needed to walk the distance
+    size_t walkingTime;
+};
+
+// uniform grid of the stops with coordinates for the nearest stop lookups,
+// stops of every cell are stored next to each other in one array
+class StopGrid {
+public:
+    // max number of stops returned by findNearest by default
+    static constexpr size_t DEFAULT_COUNT = 8;
+
+    // max distance of the returned stops by default (meters)
+    static constexpr double DEFAULT_RADIUS = 800;
+
+    // walking speed in meters per second (a bit slower than usual because of the detours)
+    static constexpr double WALKING_SPEED = 1.2;
+
+    // put all stops with coordinates into the grid
+    void create(Timetable& timetable);
+
+    [[nodiscard]]
+    bool empty() const { return stops_.empty(); }
+
+    // at most count stops closest to point within radius (meters), sorted by distance
+    [[nodiscard]]
+    std::vector<NearbyStop> findNearest(Coordinates point, size_t count=DEFAULT_COUNT,
+                                        double radius=DEFAULT_RADIUS) const;
+
+    // bytes used by the grid
+    [[nodiscard]]
+    size_t getMemoryUsage() const;
+
+private:
+    // stop with its coordinates projected to meters
+    struct GridStop {
+        double x;
+        double y;
+        Stop* stop;
+    };
+
+    // project point to meters (equirectangular projection, precise enough within a city)
+    [[nodiscard]]
+    std::pair<double, double> project(Coordinates point) const;
+
+    // the smallest cell size in meters (cells get larger if the stops are sparse)
+    static constexpr double MIN_CELL_SIZE = 200;
+
+    static constexpr double EARTH_RADIUS = 6371000;
+
+    // scale of the longitude at the mean latitude of the stops
+    double longitudeScale_ = 1;
+
+    // the lowest projected coordinates of the stops and the size of the cells
+    double minX_ = 0;
+    double minY_ = 0;
+    double cellSize_ = MIN_CELL_SIZE;
+
+    size_t columns_ = 0;
+    size_t rows_ = 0;
+
+    // stops sorted by cells (row-major)
+    std::vector<GridStop> stops_;
+
+    // cell -> index of its first stop
+    std::vector<uint32_t> cellOffsets_;
+};
+
+#endif
@@ -0,0 +1,38 @@
+#include "StringPool.hpp"
+
+StringId StringPool::intern(std::string_view s) {
+    if (auto&& it = ids_.find(s); it != ids_.end()) return it->second;
+
+    auto id = static_cast<StringId>(size());
+    auto&& oldData = chars_.data();
+    chars_.insert(chars_.end(), s.begin(), s.end());
+    offsets_.emplace_back(static_cast<uint32_t>(chars_.size()));
+
+    // keys of the lookup table view into chars_
+    if (chars_.data() != oldData) rebuildLookup();
+    else ids_.emplace(get(id), id);
+
+    return id;
+}
+
+std::optional<StringId> StringPool::find(std::string_view s) const {
+    if (auto&& it = ids_.find(s); it != ids_.end()) return it->second;
+    return std::nullopt;
+}
+
+void StringPool::rebuildLookup() {
+    ids_.clear();
+    for (StringId id = 0; id < size(); ++id) {
+        ids_.emplace(get(id), id);
+    }
+}
+
+size_t StringPool::getMemoryUsage() const {
+    return chars_.capacity() + offsets_.capacity() * sizeof(uint32_t);
+}
+
+size_t StringPool::getHashMemoryUsage() const {
+    // buckets + nodes (key, value and the pointer to the next node)
+    return ids_.bucket_count() * sizeof(void*) +
+        ids_.size() * (sizeof(std::pair<const std::string_view, StringId>) + sizeof(void*));
+}
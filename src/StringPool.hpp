@@ -0,0 +1,56 @@
+#ifndef STRINGPOOL_HPP_
+#define STRINGPOOL_HPP_
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using StringId = uint32_t;
+
+// stores every distinct string only once, strings are referenced by 32-bit ids
+class StringPool {
+public:
+    StringPool() : offsets_{0} {}
+
+    // get id of s, s is added to the pool if it isn't there yet
+    StringId intern(std::string_view s);
+
+    // get id of s without adding it, nullopt if s isn't in the pool
+    [[nodiscard]]
+    std::optional<StringId> find(std::string_view s) const;
+
+    // get the string with the given id
+    [[nodiscard]]
+    std::string_view get(StringId id) const {
+        return {chars_.data() + offsets_[id], offsets_[id + 1] - offsets_[id]};
+    }
+
+    // number of distinct strings
+    [[nodiscard]]
+    size_t size() const { return offsets_.size() - 1; }
+
+    // bytes used by the strings themselves (characters and offsets)
+    [[nodiscard]]
+    size_t getMemoryUsage() const;
+
+    // bytes used by the lookup table
+    [[nodiscard]]
+    size_t getHashMemoryUsage() const;
+
+private:
+    // recreate lookup keys after chars_ was reallocated
+    void rebuildLookup();
+
+    // all strings concatenated
+    std::vector<char> chars_;
+
+    // string with id i is chars_[offsets_[i], offsets_[i + 1])
+    std::vector<uint32_t> offsets_;
+
+    // maps string (viewing into chars_) to its id
+    std::unordered_map<std::string_view, StringId> ids_;
+};
+
+#endif
@@ -1,15 +1,102 @@
 #include "Timetable.hpp"
 
 #include <iostream>
+#include <iomanip>
 #include <algorithm>
+#include <tuple>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <type_traits>
+
+namespace {
+
+// memory used by the buckets and node links of a hash table
+template<typename Map>
+size_t getHashOverhead(const Map& map) {
+    return map.bucket_count() * sizeof(void*) +
+        map.size() * (sizeof(void*) + sizeof(typename Map::key_type));
+}
+
+template<typename T, typename Allocator>
+size_t getVectorMemory(const std::vector<T, Allocator>& v) {
+    return v.capacity() * sizeof(T);
+}
+
+// copy v into memory of resource, pmr vectors keep their resource when assigned, so v is constructed again
+template<typename T>
+void moveToResource(std::pmr::vector<T>& v, std::pmr::memory_resource* resource) {
+    std::pmr::vector<T> moved{v.begin(), v.end(), resource};
+    std::destroy_at(&v);
+    std::construct_at(&v, std::move(moved));
+}
+
+// bytes of v in an arena, all arrays are aligned to 8 bytes
+template<typename T>
+size_t getArenaSize(const std::pmr::vector<T>& v) {
+    return (v.size() * sizeof(T) + 7) / 8 * 8;
+}
+
+// FNV-1a
+void hashValue(uint64_t& hash, uint64_t value) {
+    for (size_t i = 0; i < sizeof(value); ++i) {
+        hash ^= (value >> (i * 8)) & 0xff;
+        hash *= 0x100000001b3;
+    }
+}
+
+// FNV-1a of route id and time offsets
+uint64_t getOffsetsHash(size_t routeId, const std::vector<uint32_t>& offsets) {
+    uint64_t hash = 0xcbf29ce484222325 ^ routeId;
+    for (auto&& offset: offsets) {
+        hash ^= offset;
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+// true if later doesn't arrive at or depart from any of the stopCount stops before earlier
+bool isLater(const TripTimes& earlier, const TripTimes& later, size_t stopCount) {
+    for (size_t i = 0; i < stopCount; ++i) {
+        if (later.getArrivalTime(i) < earlier.getArrivalTime(i) ||
+            later.getDepartureTime(i) < earlier.getDepartureTime(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// replace current by next, the previous object is released (maybe destroyed) after unlocking mutex
+template<typename T>
+void publish(std::mutex& mutex, std::shared_ptr<const T>& current,
+             std::type_identity_t<std::shared_ptr<const T>> next) {
+    std::unique_lock lock{mutex};
+    current.swap(next);
+    lock.unlock();
+}
+
+}
+
+void Timetable::readStops(std::ifstream& in, bool withCoordinates) {
+    constexpr double unknown = std::numeric_limits<double>::quiet_NaN();
+    auto parseCoordinate = [](const std::string& s) { return s.empty() ? unknown : std::stod(s); };
 
-void Timetable::readStops(std::ifstream& in) {
     while (in.peek() != EOF) {
-        auto&& [_id, name] = readLine<STOPS_COLUMN_COUNT>(in);
+        // lat and lon stay empty without coordinates
+        std::array<std::string, STOPS_WITH_COORDINATES_COLUMN_COUNT> columns;
+        if (withCoordinates) columns = readLine<STOPS_WITH_COORDINATES_COLUMN_COUNT>(in);
+        else std::ranges::move(readLine<STOPS_COLUMN_COUNT>(in), columns.begin());
+        auto&& [_id, name, lat, lon] = columns;
         auto id = static_cast<size_t>(std::stoi(_id));
 
         // create stop
-        stops_.try_emplace(id, id, std::move(name));
+        auto&& [it, _] = stops_.try_emplace(id, id, strings_.intern(name));
+        stopsByName_[it->second.getNameId()].emplace_back(&it->second);
+        stopCount_ = std::max(stopCount_, id + 1);
+
+        if (coordinates_.size() < stopCount_) coordinates_.resize(stopCount_, {unknown, unknown});
+        coordinates_[id] = {parseCoordinate(lat), parseCoordinate(lon)};
     }
 }
 
@@ -20,7 +107,7 @@ void Timetable::readRoutes(std::ifstream& in) {
         auto type = static_cast<size_t>(std::stoi(_type));
 
         // create route
-        routes_.try_emplace(id, id, std::move(name), type);
+        routes_.try_emplace(id, id, strings_.intern(name), type);
     }
 }
 
@@ -35,7 +122,7 @@ void Timetable::readTrips(std::ifstream& in) {
         auto&& route = routes_.at(routeId);
 
         // create trip
-        auto&& [it, _] = trips_.try_emplace(id, id, &route, std::move(headsign), direction);
+        auto&& [it, _] = trips_.try_emplace(id, id, &route, strings_.intern(headsign), direction);
 
         auto&& trip = it->second;
         route.getTrips().emplace_back(&trip);
@@ -44,21 +131,65 @@ void Timetable::readTrips(std::ifstream& in) {
 
 void Timetable::readStopTimes(std::ifstream& in) {
     Trip* scannedTrip = nullptr;
-    bool addStops;
+    bool addStops = false;
+
+    // stop times of scannedTrip
+    std::vector<uint32_t> arrivals;
+    std::vector<uint32_t> departures;
+
+    // trip, its base time and indices of its arrival and departure offsets in the stop times of its route
+    std::vector<std::tuple<Trip*, uint32_t, uint32_t, uint32_t>> tripStopTimes;
+
+    // hash of offsets -> route and index of the offsets in its stop times
+    std::unordered_multimap<uint64_t, std::pair<Route*, uint32_t>> patterns;
+
+    // add offsets to the stop times of route, reuse the same offsets if compressing
+    auto addOffsets = [&](Route* route, const std::vector<uint32_t>& offsets) {
+        auto&& stopTimes = route->getStopTimes();
+        uint64_t hash = getOffsetsHash(route->getId(), offsets);
+        if (compressStopTimes_) {
+            for (auto&& [it, last] = patterns.equal_range(hash); it != last; ++it) {
+                auto&& [r, index] = it->second;
+                if (r == route && std::equal(offsets.begin(), offsets.end(), stopTimes.begin() + index)) {
+                    return index;
+                }
+            }
+        }
+        auto index = static_cast<uint32_t>(stopTimes.size());
+        stopTimes.insert(stopTimes.end(), offsets.begin(), offsets.end());
+        if (compressStopTimes_) patterns.emplace(hash, std::pair{route, index});
+        return index;
+    };
+
+    // store the stop times of scannedTrip as offsets from its earliest time
+    auto addTripStopTimes = [&]() {
+        if (scannedTrip == nullptr) return;
+        auto baseTime = std::min(std::ranges::min(arrivals), std::ranges::min(departures));
+        for (auto&& time: arrivals) time -= baseTime;
+        for (auto&& time: departures) time -= baseTime;
+
+        auto&& route = scannedTrip->getRoute();
+        auto arrivalIndex = addOffsets(route, arrivals);
+
+        // the trip doesn't wait at any stop - departures are the same as arrivals
+        auto departureIndex = compressStopTimes_ && departures == arrivals ?
+            arrivalIndex : addOffsets(route, departures);
+
+        tripStopTimes.emplace_back(scannedTrip, baseTime, arrivalIndex, departureIndex);
+        arrivals.clear();
+        departures.clear();
+    };
 
     while (in.peek() != EOF) {
         auto&& [tripId_, arrTime_, depTime_, stopId_] = readLine<STOP_TIMES_COLUMN_COUNT>(in);
         auto tripId = static_cast<size_t>(std::stoi(tripId_));
-        auto arrTime = static_cast<size_t>(std::stoi(arrTime_));
-        auto depTime = static_cast<size_t>(std::stoi(depTime_));
+        auto arrTime = static_cast<uint32_t>(std::stoi(arrTime_));
+        auto depTime = static_cast<uint32_t>(std::stoi(depTime_));
         auto stopId = static_cast<size_t>(std::stoi(stopId_));
 
         auto&& trip = trips_.at(tripId);
         auto&& stop = stops_.at(stopId);
 
-        // add arrival and departure time for stop in trip
-        trip.addTimes(arrTime, depTime);
-
         auto&& stopRoutes = stop.getRoutes();
         auto&& route = trip.getRoute();
 
@@ -69,6 +200,7 @@ void Timetable::readStopTimes(std::ifstream& in) {
 
         // if there's a new trip
         if (scannedTrip != &trip) {
+            addTripStopTimes();
             scannedTrip = &trip;
             addStops = false;
 
@@ -76,100 +208,457 @@ void Timetable::readStopTimes(std::ifstream& in) {
             if (route->getStops().empty()) addStops = true;
         }
 
+        // add arrival and departure time for stop in trip
+        arrivals.emplace_back(arrTime);
+        departures.emplace_back(depTime);
+
         if (addStops) route->getStops().emplace_back(&stop);
     }
+    addTripStopTimes();
+
+    // stop times of the routes are complete, trips can point into them
+    for (auto&& [_, route]: routes_) {
+        route.getStopTimes().shrink_to_fit();
+        route.updateTripTimes();
+    }
+    for (auto&& [trip, baseTime, arrivalIndex, departureIndex]: tripStopTimes) {
+        auto&& stopTimes = trip->getRoute()->getStopTimes();
+        trip->setStopTimes(baseTime, stopTimes.data() + arrivalIndex, stopTimes.data() + departureIndex);
+    }
 }
 
-void Timetable::readCSVData() {
+bool Timetable::readCSVData(bool compressStopTimes, const std::string& directory) {
+    compressStopTimes_ = compressStopTimes;
+    directory_ = directory;
     std::array filenames{STOPS, ROUTES, TRIPS, STOP_TIMES};
 
     for (auto&& filename: filenames) {
-        std::ifstream file{filename};
+        std::ifstream file{directory_ + '/' + filename};
         if (!file.good() || !file.is_open()) {
-            std::cout << "Can't read " << filename << '\n';
-            break;
+            std::cout << "Can't read " << directory_ << '/' << filename << '\n';
+            return false;
         }
         std::string firstLine;
         std::getline(file, firstLine); // skip the first line - column names
 
-        if (filename == STOPS) readStops(file);
+        if (filename == STOPS) readStops(file, firstLine.find("stop_lat") != std::string::npos);
         else if (filename == ROUTES) readRoutes(file);
         else if (filename == TRIPS) readTrips(file);
         else if (filename == STOP_TIMES) readStopTimes(file);
     }
+    createSchedule();
+    return true;
 }
 
-std::vector<Stop*> Timetable::getMarkedStops() {
-    std::vector<Stop*> marked;
-    for (auto&& [_, stop]: stops_) {
-        if (stop.isMarked()) marked.emplace_back(&stop);
-    }
-    return marked;
+std::shared_ptr<const Schedule> Timetable::getSchedule() const {
+    std::scoped_lock lock{currentMutex_};
+    return schedule_;
 }
 
-[[maybe_unused]]
-std::vector<Stop*> Timetable::getStopsByName(const std::string& name) {
-    std::vector<Stop*> stopsFound;
-    for (auto&& [_, stop]: stops_) {
-        if (stop.getName() == name) {
-            stopsFound.emplace_back(&stop);
+std::shared_ptr<const TripTransfers> Timetable::getTripTransfers() const {
+    std::scoped_lock lock{currentMutex_};
+    return tripTransfers_;
+}
+
+std::shared_ptr<const Connections> Timetable::getConnections() const {
+    std::scoped_lock lock{currentMutex_};
+    return connections_;
+}
+
+std::shared_ptr<const Departures> Timetable::getDepartures() const {
+    std::scoped_lock lock{currentMutex_};
+    return departures_;
+}
+
+void Timetable::computeTripTransfers(size_t threadCount) {
+    auto&& tripTransfers = std::make_shared<TripTransfers>();
+    tripTransfers->compute(*this, threadCount);
+    publish(currentMutex_, tripTransfers_, std::move(tripTransfers));
+}
+
+bool Timetable::saveTripTransfers() const {
+    std::ofstream file{directory_ + '/' + TRIP_TRANSFERS, std::ios::binary};
+    return file.is_open() && getTripTransfers()->save(file);
+}
+
+bool Timetable::loadTripTransfers() {
+    std::ifstream file{directory_ + '/' + TRIP_TRANSFERS, std::ios::binary};
+    auto&& tripTransfers = std::make_shared<TripTransfers>();
+    if (!file.is_open() || !tripTransfers->load(file, *this)) return false;
+    publish(currentMutex_, tripTransfers_, std::move(tripTransfers));
+    return true;
+}
+
+void Timetable::createConnections() {
+    auto&& connections = std::make_shared<Connections>();
+    connections->create(*this);
+    publish(currentMutex_, connections_, std::move(connections));
+}
+
+void Timetable::createDepartures() {
+    auto&& departures = std::make_shared<Departures>();
+    departures->create(*this);
+    publish(currentMutex_, departures_, std::move(departures));
+}
+
+size_t Timetable::applyDelays(std::span<const TripDelay> delays) {
+    std::scoped_lock lock{delaysMutex_};
+    std::vector<const Route*> delayedRoutes;
+    for (auto&& [id, delay]: delays) {
+        auto&& it = trips_.find(id);
+        if (it == trips_.end() || it->second.getDelay() == delay) continue;
+        it->second.setDelay(delay);
+        delayedRoutes.emplace_back(it->second.getRoute());
+    }
+    auto&& changedTrips = delayedRoutes.size();
+    if (changedTrips == 0) return 0;
+
+    // the new schedule shares the routes without changes with the current one
+    std::ranges::sort(delayedRoutes);
+    delayedRoutes.erase(std::unique(delayedRoutes.begin(), delayedRoutes.end()), delayedRoutes.end());
+    auto&& schedule = getSchedule();
+    auto routes = schedule->getRoutes();
+    for (auto&& route: delayedRoutes) routes[route->getId()] = createRouteTrips(*route);
+    publish(currentMutex_, schedule_, std::make_shared<const Schedule>(std::move(routes)));
+
+    // the derived indices created so far would keep the old times
+    if (!getTripTransfers()->empty() || !getConnections()->empty() || !getDepartures()->empty()) {
+        std::scoped_lock indexLock{indexMutex_};
+        staleIndices_ = true;
+        if (!indexThread_.joinable()) {
+            indexThread_ = std::jthread{[this](std::stop_token stop) { runIndexThread(std::move(stop)); }};
         }
+        indexChanged_.notify_all();
     }
-    return stopsFound;
+    return changedTrips;
 }
 
-void Timetable::createTransfers() {
-    for (auto&& [_, stop]: stops_) {
-        for (auto&& [_id, s]: stops_) {
+void Timetable::waitForIndices() {
+    std::unique_lock lock{indexMutex_};
+    indexChanged_.wait(lock, [this] { return !staleIndices_ && !rebuildingIndices_; });
+}
+
+void Timetable::runIndexThread(std::stop_token stop) {
+    std::unique_lock lock{indexMutex_};
+    while (indexChanged_.wait(lock, stop, [this] { return staleIndices_; })) {
+        staleIndices_ = false;
+        rebuildingIndices_ = true;
+        lock.unlock();
+        rebuildIndices();
+        lock.lock();
+        rebuildingIndices_ = false;
+        indexChanged_.notify_all();
+    }
+}
 
-            // compare names (or possibly node ids of the stops)
-            if (stop != s && stop.getName() == s.getName()) {
+void Timetable::rebuildIndices() {
+    auto&& schedule = getSchedule();
+    auto isStale = [&schedule](auto&& index) { return !index->empty() && index->getSchedule() != schedule; };
+    if (isStale(getTripTransfers())) computeTripTransfers();
+    if (isStale(getConnections())) createConnections();
+    if (isStale(getDepartures())) createDepartures();
+}
 
-                // add transfer from stop to s
+std::shared_ptr<const RouteTrips> Timetable::createRouteTrips(const Route& route) const {
+    auto&& trips = route.getTrips();
+    auto&& stopCount = route.getStops().size();
+    if (stopCount == 0 || std::ranges::none_of(trips, [](auto&& trip) { return trip->getDelay() != 0; })) {
+        return std::make_shared<const RouteTrips>(route);
+    }
 
-                if (transfers_.contains(&stop)) {
-                    transfers_[&stop].emplace_back(&s);
-                }
-                else {
-                   transfers_.try_emplace(&stop, std::vector{&s});
-                }
+    // delayed times of the trips in the order of the departure from the first stop
+    std::vector<TripTimes> times;
+    times.reserve(trips.size());
+    for (auto&& trip: trips) {
+        times.push_back({trip->getDelayedBaseTime(), trip->getArrivalOffsets(), trip->getDepartureOffsets()});
+    }
+    std::vector<uint32_t> order(trips.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::stable_sort(order, {}, [&times](auto&& t) { return times[t].getDepartureTime(0); });
+
+    // the trips overtaking an earlier trip at some stop (e.g. they run faster with a delay) go to the first lane
+    // where they don't overtake the last trip, the lanes are created from scratch every time,
+    // so the trips back on time are merged back and no lane stays empty
+    std::vector<std::vector<uint32_t>> lanes;
+    for (auto&& t: order) {
+        auto&& lane = std::ranges::find_if(lanes, [&](auto&& l) {
+            return isLater(times[l.back()], times[t], stopCount);
+        });
+        if (lane != lanes.end()) lane->emplace_back(t);
+        else lanes.push_back({t});
+    }
+
+    std::vector<Trip*> laneTrips;
+    std::vector<TripTimes> laneTimes;
+    std::vector<uint32_t> laneEnds;
+    std::vector<uint32_t> positions(trips.size());
+    laneTrips.reserve(trips.size());
+    laneTimes.reserve(trips.size());
+    for (auto&& lane: lanes) {
+        for (auto&& t: lane) {
+            positions[t] = static_cast<uint32_t>(laneTrips.size());
+            laneTrips.emplace_back(trips[t]);
+            laneTimes.emplace_back(times[t]);
+        }
+        laneEnds.emplace_back(static_cast<uint32_t>(laneTrips.size()));
+    }
+    return std::make_shared<const RouteTrips>(std::move(laneTrips), std::move(laneTimes), std::move(laneEnds),
+                                              std::move(positions));
+}
+
+void Timetable::createSchedule() {
+    size_t routeCount = 0;
+    for (auto&& [_, route]: routes_) routeCount = std::max(routeCount, route.getId() + 1);
+    std::vector<std::shared_ptr<const RouteTrips>> routes(routeCount);
+    for (auto&& [_, route]: routes_) routes[route.getId()] = createRouteTrips(route);
+    publish(currentMutex_, schedule_, std::make_shared<const Schedule>(std::move(routes)));
+}
+
+void Timetable::renumber() {
+    std::vector<Stop*> stops;
+    for (auto&& [_, stop]: stops_) stops.emplace_back(&stop);
+    std::ranges::sort(stops, {}, &Stop::getId);
+
+    size_t routeCount = 0;
+    for (auto&& [id, _]: routes_) routeCount = std::max(routeCount, id + 1);
+
+    // breadth-first traversal of the routes, order is the queue of the reached stops
+    std::vector<Stop*> order;
+    std::vector<Route*> routeOrder;
+    std::vector<bool> reached(stopCount_), routeReached(routeCount);
+    auto reach = [&](Stop* stop) {
+        for (auto&& s: stopsByName_.at(stop->getNameId())) {
+            if (reached[s->getId()]) continue;
+            reached[s->getId()] = true;
+            order.emplace_back(s);
+        }
+    };
+    for (auto&& start: stops) {
+        if (reached[start->getId()]) continue;
+        reach(start);
+        for (size_t next = order.size() - 1; next < order.size(); ++next) {
+            for (auto&& route: order[next]->getRoutes()) {
+                if (routeReached[route->getId()]) continue;
+                routeReached[route->getId()] = true;
+                routeOrder.emplace_back(route);
+                for (auto&& stop: route->getStops()) reach(stop);
             }
         }
     }
+    for (auto&& [_, route]: routes_) {
+        if (!routeReached[route.getId()]) routeOrder.emplace_back(&route);
+    }
+    for (size_t id = 0; id < routeOrder.size(); ++id) routeOrder[id]->setId(id);
+
+    // copy the stops in the new order, so that they are allocated next to each other
+    std::unordered_map<Id, Stop> renumbered;
+    renumbered.reserve(stops_.size());
+    std::vector<Stop*> moved(stopCount_);
+    std::vector<Coordinates> coordinates(order.size());
+    for (size_t id = 0; id < order.size(); ++id) {
+        auto&& stop = order[id];
+        auto&& [it, _] = renumbered.try_emplace(stop->getOriginalId(), *stop);
+        it->second.setId(id);
+        std::ranges::sort(it->second.getRoutes(), {}, &Route::getId);
+        moved[stop->getId()] = &it->second;
+        coordinates[id] = coordinates_[stop->getId()];
+    }
+
+    for (auto&& [_, route]: routes_) {
+        for (auto&& stop: route.getStops()) stop = moved[stop->getId()];
+    }
+    for (auto&& [_, sameName]: stopsByName_) {
+        for (auto&& stop: sameName) stop = moved[stop->getId()];
+        std::ranges::sort(sameName, {}, &Stop::getId);
+    }
+    stops_ = std::move(renumbered);
+    coordinates_ = std::move(coordinates);
+    stopCount_ = order.size();
+    createSchedule();
 }
 
-void Timetable::addArtificialTransfers(Stop* src, Stop* dest) {
-    transfers_.try_emplace(src);
-    for (auto&& [_, stop]: stops_) {
+bool Timetable::compact(HugePages hugePages) {
+    // the indices being created read the arrays of the routes
+    waitForIndices();
+
+    std::vector<Route*> routes;
+    for (auto&& [_, route]: routes_) routes.emplace_back(&route);
+    std::ranges::sort(routes, {}, &Route::getId);
+    std::vector<Stop*> stops;
+    for (auto&& [_, stop]: stops_) stops.emplace_back(&stop);
+    std::ranges::sort(stops, {}, &Stop::getId);
+
+    size_t size = 0;
+    for (auto&& route: routes) {
+        size += getArenaSize(route->getStops()) + getArenaSize(route->getTrips()) +
+            getArenaSize(route->getTripTimes()) + getArenaSize(route->getStopTimes());
+    }
+    for (auto&& stop: stops) size += getArenaSize(stop->getRoutes());
 
-        // compare names (or possibly node ids of the stops)
-        if (src != &stop && src->getName() == stop.getName()) {
+    // a new arena, the arrays may be in the previous one till they are moved
+    auto&& arena = std::make_unique<Arena>();
+    if (!arena->reserve(size, hugePages)) {
+        std::cout << "Can't map " << size << " bytes for the timetable\n";
+        return false;
+    }
 
-            // add transfer from src to stop
-            transfers_[src].emplace_back(&stop);
+    // the arrays scanned together are next to each other
+    for (auto&& route: routes) {
+        moveToResource(route->getStops(), arena.get());
+        moveToResource(route->getTrips(), arena.get());
+        moveToResource(route->getTripTimes(), arena.get());
+        auto&& oldData = route->getStopTimes().data();
+        moveToResource(route->getStopTimes(), arena.get());
+        auto&& trips = route->getTrips();
+        for (size_t t = 0; t < trips.size(); ++t) {
+            trips[t]->setTimes(&route->getTripTimes()[t]);
+            trips[t]->moveStopTimes(oldData, route->getStopTimes().data());
         }
+    }
+    for (auto&& stop: stops) moveToResource(stop->getRoutes(), arena.get());
 
-        // compare names (or possibly node ids of the stops)
-        else if (&stop != dest && stop.getName() == dest->getName()) {
+    // the schedule and the indices point into the previous arrays
+    createSchedule();
+    rebuildIndices();
+    arena_ = std::move(arena);
+    return true;
+}
 
-            // add transfer from stop to dest
-            transfers_[&stop].emplace_back(dest);
+const std::vector<Stop*>& Timetable::getStopsByName(std::string_view name) const {
+    static const std::vector<Stop*> noStops;
+    auto&& nameId = strings_.find(name);
+    if (!nameId) return noStops;
+    auto&& it = stopsByName_.find(*nameId);
+    return it != stopsByName_.end() ? it->second : noStops;
+}
+
+void Timetable::createTransfers() {
+    // transfers between all stops with the same name (or possibly node ids of the stops)
+    for (auto&& [_, stops]: stopsByName_) {
+        for (auto&& stop: stops) {
+            for (auto&& s: stops) {
+                if (stop != s) transfers_[stop].emplace_back(s);
+            }
+        }
+    }
+}
+
+std::vector<StopOffset> Timetable::getStopsAround(Coordinates point, size_t count, double radius) const {
+    std::vector<StopOffset> stops;
+    for (auto&& [stop, _, walkingTime]: stopGrid_.findNearest(point, count, radius)) {
+        stops.push_back({stop, walkingTime});
+    }
+    return stops;
+}
+
+std::optional<Coordinates> Timetable::getCoordinates(const Stop& stop) const {
+    auto&& coordinates = coordinates_[stop.getId()];
+    if (std::isnan(coordinates.latitude) || std::isnan(coordinates.longitude)) return std::nullopt;
+    return coordinates;
+}
+
+Query Timetable::createQuery(std::string_view startName, std::string_view endName, size_t startTime) const {
+    Query query;
+    query.startTime = startTime;
+    if (auto&& point = Coordinates::parse(startName)) query.access = getStopsAround(*point);
+    else for (auto&& stop: getStopsByName(startName)) query.access.push_back({stop, 0});
+
+    if (auto&& point = Coordinates::parse(endName)) query.egress = getStopsAround(*point);
+    else for (auto&& stop: getStopsByName(endName)) query.egress.push_back({stop, TripTransfers::TRANSFER_TIME});
+    return query;
+}
+
+uint64_t Timetable::getFingerprint() {
+    uint64_t hash = 0xcbf29ce484222325;
+
+    std::vector<Trip*> trips;
+    for (auto&& [_, trip]: trips_) trips.emplace_back(&trip);
+    std::ranges::sort(trips, {}, &Trip::getId);
+
+    hashValue(hash, trips.size());
+    for (auto&& trip: trips) {
+        hashValue(hash, trip->getId());
+        auto&& stops = trip->getRoute()->getStops();
+        for (size_t i = 0; i < stops.size(); ++i) {
+            hashValue(hash, stops[i]->getId());
+            hashValue(hash, trip->getArrivalTime(i));
+            hashValue(hash, trip->getDepartureTime(i));
         }
     }
+
+    // walking transfers depend on the names of the stops
+    std::vector<Stop*> stops;
+    for (auto&& [_, stop]: stops_) stops.emplace_back(&stop);
+    std::ranges::sort(stops, {}, &Stop::getId);
+    for (auto&& stop: stops) {
+        hashValue(hash, stop->getId());
+        hashValue(hash, stop->getNameId());
+    }
+    return hash;
 }
 
-std::pair<Stop&, Stop&> Timetable::createArtificialStops(const std::string& startName, const std::string& endName) {
-    size_t startId = SIZE_MAX;
-    size_t endId = SIZE_MAX - 1;
+MemoryUsage Timetable::getMemoryUsage() const {
+    MemoryUsage usage;
+
+    usage.trips = trips_.size() * sizeof(Trip);
+
+    for (auto&& [_, route]: routes_) {
+        usage.trips += getVectorMemory(route.getTripTimes());
+        usage.routes += sizeof(Route) + getVectorMemory(route.getStops()) + getVectorMemory(route.getTrips());
+        usage.stopTimes += getVectorMemory(route.getStopTimes());
+    }
+
+    for (auto&& [_, stop]: stops_) {
+        usage.stops += sizeof(Stop) + getVectorMemory(stop.getRoutes());
+    }
+    usage.stops += getVectorMemory(coordinates_);
+
+    for (auto&& [_, stops]: stopsByName_) {
+        usage.stops += sizeof(std::vector<Stop*>) + getVectorMemory(stops);
+    }
+
+    for (auto&& [_, toStops]: transfers_) {
+        usage.transfers += sizeof(std::vector<To*>) + getVectorMemory(toStops);
+    }
 
-    // create startStop
-    auto&& [it, _] = stops_.try_emplace(startId, startId, startName, true);
-    auto&& startStop = it->second;
+    usage.strings = strings_.getMemoryUsage();
+    usage.tripTransfers = getTripTransfers()->getMemoryUsage();
+    usage.connections = getConnections()->getMemoryUsage();
+    usage.departures = getDepartures()->getMemoryUsage();
+    usage.stopGrid = stopGrid_.getMemoryUsage();
+    usage.schedule = getSchedule()->getMemoryUsage();
 
-    // create endStop
-    auto&& [_it, _bool] = stops_.try_emplace(endId, endId, endName, true);
-    auto&& endStop = _it->second;
+    usage.hashOverhead = getHashOverhead(stops_) + getHashOverhead(routes_) + getHashOverhead(trips_) +
+        getHashOverhead(transfers_) + getHashOverhead(stopsByName_) + strings_.getHashMemoryUsage();
 
-    addArtificialTransfers(&startStop, &endStop);
-    return {startStop, endStop};
+    return usage;
+}
+
+void Timetable::printMemoryUsage(std::ostream& out) const {
+    auto&& usage = getMemoryUsage();
+    auto printLine = [&out](const char* name, size_t bytes) {
+        out << "  " << std::left << std::setw(14) << name << std::right << std::setw(10)
+            << std::fixed << std::setprecision(2) << static_cast<double>(bytes) / (1 << 20) << " MiB\n";
+    };
+
+    out << "Memory usage (" << stops_.size() << " stops, " << routes_.size() << " routes, "
+        << trips_.size() << " trips, " << strings_.size() << " strings):\n";
+    printLine("stop times", usage.stopTimes);
+    printLine("trips", usage.trips);
+    printLine("routes", usage.routes);
+    printLine("stops", usage.stops);
+    printLine("transfers", usage.transfers);
+    printLine("strings", usage.strings);
+    printLine("hash overhead", usage.hashOverhead);
+    printLine("trip transfers", usage.tripTransfers);
+    printLine("connections", usage.connections);
+    printLine("departures", usage.departures);
+    printLine("stop grid", usage.stopGrid);
+    printLine("schedule", usage.schedule);
+    printLine("total", usage.total());
+    if (arena_) {
+        out << "  stops and routes in an arena of " << std::setprecision(2)
+            << static_cast<double>(arena_->getSize()) / (1 << 20) << " MiB, huge pages: "
+            << getHugePagesName(arena_->getHugePages()) << '\n';
+    }
 }
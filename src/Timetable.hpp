@@ -1,37 +1,148 @@
 #ifndef TIMETABLE_HPP_
 #define TIMETABLE_HPP_
 
+#include "Arena.hpp"
 #include "DataTypes.hpp"
+#include "Query.hpp"
+#include "TripTransfers.hpp"
+#include "Connections.hpp"
+#include "Departures.hpp"
+#include "DelayFeed.hpp"
+#include "Schedule.hpp"
+#include "StopGrid.hpp"
 
 #include <array>
+#include <condition_variable>
 #include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
 
 using From = Stop;
 using To = Stop;
 using Id = size_t;
 
+// bytes used by the parts of the timetable
+struct MemoryUsage {
+    size_t stopTimes = 0;
+    size_t trips = 0;
+    size_t routes = 0;
+    size_t stops = 0;
+    size_t transfers = 0;
+    size_t strings = 0;
+
+    // buckets and node links of all hash tables
+    size_t hashOverhead = 0;
+
+    // precomputed transfers of the Trip-Based search
+    size_t tripTransfers = 0;
+
+    // sorted connections of the Connection Scan Algorithm
+    size_t connections = 0;
+
+    // departure boards of the stops
+    size_t departures = 0;
+
+    // spatial index of the stops
+    size_t stopGrid = 0;
+
+    // trips of the routes in the current schedule (with the copies of the delayed trips)
+    size_t schedule = 0;
+
+    [[nodiscard]]
+    size_t total() const {
+        return stopTimes + trips + routes + stops + transfers + strings + hashOverhead + tripTransfers +
+            connections + departures + stopGrid + schedule;
+    }
+};
+
 class Timetable {
 public:
 
-    // read all the csv files and create all Stops, Routes and Trips
-    void readCSVData();
+    // directory with the csv files used by default
+    static constexpr auto DATA_DIRECTORY{"data"};
+
+    // read all the csv files from directory and create all Stops, Routes and Trips
+    // (stops.csv may contain stop_lat and stop_lon columns after the name)
+    // with compressStopTimes, trips of a route running the same pattern shifted in time
+    // share their stop time offsets (and arrivals are shared with departures if there is no waiting)
+    // returns false if some file can't be read
+    bool readCSVData(bool compressStopTimes=false, const std::string& directory=DATA_DIRECTORY);
 
-    // create transfers for real (not artificial) stops
+    // renumber stops and routes for locality: the stops of a route (and stops with the same name)
+    // get consecutive ids and are stored next to each other, routes are numbered in the order they are reached
+    // must be called right after readCSVData, the original ids stay available for the output
+    void renumber();
+
+    // move the arrays read by the searches (stops, trips, times of the trips and stop times of the routes
+    // and routes of the stops)
+    // into one arena backed by hugePages, stored in the order of the route and stop ids,
+    // must be called after readCSVData (and renumber) and not while searches are running,
+    // the indices created so far are created again, returns false if the arena can't be mapped
+    bool compact(HugePages hugePages=HugePages::Transparent);
+
+    // create transfers between stops with the same name
     void createTransfers();
 
-    // add transfers from artificial source and to artificial destination
-    void addArtificialTransfers(Stop* src, Stop* dest);
+    // set the current delays of trips (trips not in delays keep theirs), returns the number of changed trips
+    // the delayed times are published as a new schedule, the searches already running keep the previous one;
+    // the trips of a delayed route overtaking an earlier trip at some stop go to another lane of the route
+    // (see RouteTrips), the trip transfers, connections and departures created so far are created again
+    // in the background, till then they keep the times of the previous schedule (see waitForIndices)
+    size_t applyDelays(std::span<const TripDelay> delays);
+
+    // wait till the trip transfers, connections and departures are created again after applyDelays
+    void waitForIndices();
 
-    // create artificial source and destination stops
-    std::pair<Stop&, Stop&> createArtificialStops(const std::string& startName,
-                                                  const std::string& endName);
+    // create query from all stops named startName to all stops named endName,
+    // the destination is reached after transferring from one of its stops
+    // the names can be also coordinates "lat,lon", then the stops around are used (see createStopGrid)
+    // (the timetable isn't changed, so it can be shared by many queries)
+    [[nodiscard]]
+    Query createQuery(std::string_view startName, std::string_view endName, size_t startTime) const;
+
+    // compute trip-to-trip transfers for the Trip-Based search (takes a while)
+    void computeTripTransfers(size_t threadCount=0);
+
+    // write the computed trip-to-trip transfers next to the csv data
+    bool saveTripTransfers() const;
+
+    // read trip-to-trip transfers written by saveTripTransfers,
+    // fails if they were computed for different data
+    bool loadTripTransfers();
+
+    // create the time sorted connections for the Connection Scan Algorithm
+    // (after createTransfers, takes a moment)
+    void createConnections();
+
+    // create the time sorted departures from every stop (departure boards)
+    void createDepartures();
+
+    // create the grid of the stops with coordinates for the nearest stop lookups
+    void createStopGrid() { stopGrid_.create(*this); }
+
+    // stops around point with the time needed to walk there (from there),
+    // to be used as the access (egress) stops of a query, empty if there are no coordinates
+    [[nodiscard]]
+    std::vector<StopOffset> getStopsAround(Coordinates point, size_t count=StopGrid::DEFAULT_COUNT,
+                                           double radius=StopGrid::DEFAULT_RADIUS) const;
+
+    // coordinates of stop if they are in the data
+    [[nodiscard]]
+    std::optional<Coordinates> getCoordinates(const Stop& stop) const;
 
     // get all stops with the same name
-    [[maybe_unused]]
-    std::vector<Stop*> getStopsByName(const std::string& name);
+    [[nodiscard]]
+    const std::vector<Stop*>& getStopsByName(std::string_view name) const;
 
-    // get all marked stops for the raptor algorithm
-    std::vector<Stop*> getMarkedStops();
+    // stop ids are lower than this number (used to index per stop arrays)
+    [[nodiscard]]
+    size_t getStopCount() const { return stopCount_; }
 
     std::unordered_map<Id, Stop>& getStops() { return stops_; }
 
@@ -43,9 +154,54 @@ public:
 
     std::unordered_map<From*, std::vector<To*>>& getTransfers() { return transfers_; }
 
+    // trips of all routes with their current times, a search keeps the returned schedule for its whole run
+    [[nodiscard]]
+    std::shared_ptr<const Schedule> getSchedule() const;
+
+    // the indices are replaced when they are created again, a search keeps the returned ones for its whole run
+    [[nodiscard]]
+    std::shared_ptr<const TripTransfers> getTripTransfers() const;
+
+    [[nodiscard]]
+    std::shared_ptr<const Connections> getConnections() const;
+
+    [[nodiscard]]
+    std::shared_ptr<const Departures> getDepartures() const;
+
+    [[nodiscard]]
+    const StopGrid& getStopGrid() const { return stopGrid_; }
+
+    [[nodiscard]]
+    const StringPool& getStrings() const { return strings_; }
+
+    // arena with the arrays of the routes and stops, nullptr without compact
+    [[nodiscard]]
+    const Arena* getArena() const { return arena_.get(); }
+
+    [[nodiscard]]
+    std::string_view getName(const Stop& stop) const { return strings_.get(stop.getNameId()); }
+
+    [[nodiscard]]
+    std::string_view getName(const Route& route) const { return strings_.get(route.getNameId()); }
+
+    [[nodiscard]]
+    std::string_view getHeadsign(const Trip& trip) const { return strings_.get(trip.getHeadsignId()); }
+
+    // hash of the trips with their stop times and of the stops with their names,
+    // everything the saved trip transfers and travel time matrices depend on
+    [[nodiscard]]
+    uint64_t getFingerprint();
+
+    // compute the memory used by all parts of the timetable
+    [[nodiscard]]
+    MemoryUsage getMemoryUsage() const;
+
+    // print the memory usage report
+    void printMemoryUsage(std::ostream& out) const;
+
 private:
-    // read stops.csv
-    void readStops(std::ifstream& in);
+    // read stops.csv (withCoordinates if it has the stop_lat and stop_lon columns)
+    void readStops(std::ifstream& in, bool withCoordinates);
 
     // read routes.csv
     void readRoutes(std::ifstream& in);
@@ -56,23 +212,48 @@ private:
     // read stop_times.csv
     void readStopTimes(std::ifstream& in);
 
+    // trips of route with their delays, the trips overtaking an earlier trip at some stop are put into
+    // the first lane where they don't overtake the last trip (the scheduled trips if none is delayed)
+    [[nodiscard]]
+    std::shared_ptr<const RouteTrips> createRouteTrips(const Route& route) const;
+
+    // create the schedule of all routes (after the arrays of the routes were changed)
+    void createSchedule();
+
+    // create again the indices created for an older schedule than the current one
+    void rebuildIndices();
+
+    // create the indices again after every applyDelays till stop is requested
+    void runIndexThread(std::stop_token stop);
+
     // read line of csv file and get N columns
     template<size_t N>
     std::array<std::string, N> readLine(std::ifstream& in, char delim=',');
 
-    static constexpr auto STOPS{"data/stops.csv"};
-    static constexpr auto ROUTES{"data/routes.csv"};
-    static constexpr auto TRIPS{"data/trips.csv"};
-    static constexpr auto STOP_TIMES{"data/stop_times.csv"};
+    static constexpr auto STOPS{"stops.csv"};
+    static constexpr auto ROUTES{"routes.csv"};
+    static constexpr auto TRIPS{"trips.csv"};
+    static constexpr auto STOP_TIMES{"stop_times.csv"};
+    static constexpr auto TRIP_TRANSFERS{"trip_transfers.bin"};
 
     static constexpr size_t STOPS_COLUMN_COUNT = 2;
+    static constexpr size_t STOPS_WITH_COORDINATES_COLUMN_COUNT = 4;
     static constexpr size_t ROUTES_COLUMN_COUNT = 3;
     static constexpr size_t TRIPS_COLUMN_COUNT = 4;
     static constexpr size_t STOP_TIMES_COLUMN_COUNT = 4;
 
+    // memory of the arrays of stops and routes after compact, destroyed after them
+    std::unique_ptr<Arena> arena_;
+
     // all stops
     std::unordered_map<Id, Stop> stops_;
 
+    // the highest stop id + 1
+    size_t stopCount_ = 0;
+
+    // stop id -> coordinates of the stop (NaN if unknown)
+    std::vector<Coordinates> coordinates_;
+
     // all routes
     std::unordered_map<Id, Route> routes_;
 
@@ -81,6 +262,50 @@ private:
 
     // all possible transfers from every stop
     std::unordered_map<From*, std::vector<To*>> transfers_;
+
+    // names of stops and routes and headsigns of trips
+    StringPool strings_;
+
+    // name id -> all stops with the name
+    std::unordered_map<StringId, std::vector<Stop*>> stopsByName_;
+
+    // current schedule, replaced by applyDelays
+    std::shared_ptr<const Schedule> schedule_ =
+        std::make_shared<const Schedule>(std::vector<std::shared_ptr<const RouteTrips>>{});
+
+    // trip-to-trip transfers for the Trip-Based search
+    std::shared_ptr<const TripTransfers> tripTransfers_ = std::make_shared<const TripTransfers>();
+
+    // connections for the Connection Scan Algorithm
+    std::shared_ptr<const Connections> connections_ = std::make_shared<const Connections>();
+
+    // departures from every stop
+    std::shared_ptr<const Departures> departures_ = std::make_shared<const Departures>();
+
+    // guards the pointers to the schedule and the indices (they are replaced, never changed)
+    mutable std::mutex currentMutex_;
+
+    // applyDelays calls one at a time
+    std::mutex delaysMutex_;
+
+    // stops with coordinates in a grid
+    StopGrid stopGrid_;
+
+    // share identical stop time offsets of trips
+    bool compressStopTimes_ = false;
+
+    // directory with the csv files (and the trip transfers)
+    std::string directory_ = DATA_DIRECTORY;
+
+    // the indices are older than the schedule, they are being created again (guarded by indexMutex_)
+    bool staleIndices_ = false;
+    bool rebuildingIndices_ = false;
+    std::mutex indexMutex_;
+    std::condition_variable_any indexChanged_;
+
+    // runs runIndexThread, started by the first applyDelays with some index created,
+    // the last member - stopped and joined before the rest of the timetable is destroyed
+    std::jthread indexThread_;
 };
 
 template<size_t N>
@@ -0,0 +1,264 @@
+#include "TravelTimeMatrix.hpp"
+#include "Raptor.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace {
+
+// bytes of the header without the departure times
+constexpr size_t HEADER_SIZE = 44;
+
+// record of a finished shard in the checkpoint
+struct CheckpointRecord {
+    uint64_t jobId;
+    uint64_t shard;
+};
+
+template<typename T>
+void appendValue(std::string& out, const T& value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool readValue(const char*& in, const char* end, T& value) {
+    if (end - in < static_cast<std::ptrdiff_t>(sizeof(T))) return false;
+    std::copy_n(in, sizeof(T), reinterpret_cast<char*>(&value));
+    in += sizeof(T);
+    return true;
+}
+
+bool writeAll(int fd, const char* data, size_t size, size_t offset) {
+    while (size != 0) {
+        auto&& written = pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return false;
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+bool readAll(int fd, char* data, size_t size, size_t offset) {
+    while (size != 0) {
+        auto&& read = pread(fd, data, size, static_cast<off_t>(offset));
+        if (read < 0 && errno == EINTR) continue;
+        if (read <= 0) return false;
+        data += read;
+        size -= static_cast<size_t>(read);
+        offset += static_cast<size_t>(read);
+    }
+    return true;
+}
+
+}
+
+TravelTimeMatrix::~TravelTimeMatrix() {
+    close();
+}
+
+void TravelTimeMatrix::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
+
+bool TravelTimeMatrix::open(const std::string& filename, Timetable& timetable, const Options& options) {
+    close();
+    options_ = options;
+    options_.tileSize = std::max<uint32_t>(1, options_.tileSize);
+    options_.shardSize = std::max<uint32_t>(1, (options_.shardSize + options_.tileSize - 1) / options_.tileSize) *
+        options_.tileSize;
+    if (options_.departureTimes.empty() || HEADER_SIZE + 4 * options_.departureTimes.size() > DATA_OFFSET) {
+        std::cout << "Can't create matrix " << filename << " for " << options_.departureTimes.size()
+                  << " departure times\n";
+        return false;
+    }
+    fingerprint_ = timetable.getFingerprint();
+    stopCount_ = 0;
+    for (auto&& [_, stop]: timetable.getStops()) {
+        stopCount_ = std::max(stopCount_, static_cast<uint32_t>(stop.getOriginalId() + 1));
+    }
+
+    // copies, the header of an existing matrix overwrites them
+    auto expected = options_;
+    auto fingerprint = fingerprint_;
+    auto stopCount = stopCount_;
+    fd_ = ::open(filename.c_str(), O_RDWR);
+    if (fd_ < 0 && errno == ENOENT && !create(filename)) return false;
+    if (fd_ < 0) fd_ = ::open(filename.c_str(), O_RDWR);
+    if (fd_ < 0 || !readHeader(filename)) {
+        std::cout << "Can't open matrix " << filename << '\n';
+        close();
+        return false;
+    }
+    if (fingerprint_ != fingerprint || stopCount_ != stopCount || options_.tileSize != expected.tileSize ||
+        options_.shardSize != expected.shardSize || options_.maxTrips != expected.maxTrips ||
+        options_.departureTimes != expected.departureTimes) {
+        std::cout << "Matrix " << filename << " was computed for another timetable or with other options\n";
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TravelTimeMatrix::open(const std::string& filename) {
+    close();
+    fd_ = ::open(filename.c_str(), O_RDONLY);
+    if (fd_ < 0 || !readHeader(filename)) {
+        std::cout << "Can't open matrix " << filename << '\n';
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool TravelTimeMatrix::create(const std::string& filename) {
+    std::string header;
+    jobId_ = (static_cast<uint64_t>(std::random_device{}()) << 32) | std::random_device{}();
+    appendValue(header, MAGIC);
+    appendValue(header, VERSION);
+    appendValue(header, jobId_);
+    appendValue(header, fingerprint_);
+    appendValue(header, stopCount_);
+    appendValue(header, options_.tileSize);
+    appendValue(header, options_.shardSize);
+    appendValue(header, options_.maxTrips);
+    appendValue(header, static_cast<uint32_t>(options_.departureTimes.size()));
+    for (auto&& time: options_.departureTimes) appendValue(header, time);
+
+    // the whole file is created under a temporary name and linked, so other processes see it complete,
+    // the data stay sparse till the shards are written
+    auto&& temporary = filename + ".tmp" + std::to_string(getpid());
+    int fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    auto&& size = getOffset(options_.departureTimes.size(), 0);
+    bool ok = fd >= 0 && writeAll(fd, header.data(), header.size(), 0) &&
+        ftruncate(fd, static_cast<off_t>(size)) == 0 && fsync(fd) == 0;
+    if (fd >= 0) ::close(fd);
+    ok = ok && (link(temporary.c_str(), filename.c_str()) == 0 || errno == EEXIST);
+    unlink(temporary.c_str());
+    if (!ok) std::cout << "Can't write " << filename << '\n';
+    return ok;
+}
+
+bool TravelTimeMatrix::readHeader(const std::string& filename) {
+    std::string header(DATA_OFFSET, '\0');
+    if (!readAll(fd_, header.data(), header.size(), 0)) return false;
+    const char* in = header.data();
+    const char* end = in + header.size();
+    uint32_t magic = 0, version = 0, timeCount = 0;
+    if (!readValue(in, end, magic) || magic != MAGIC || !readValue(in, end, version) || version != VERSION ||
+        !readValue(in, end, jobId_) || !readValue(in, end, fingerprint_) || !readValue(in, end, stopCount_) ||
+        !readValue(in, end, options_.tileSize) || !readValue(in, end, options_.shardSize) ||
+        !readValue(in, end, options_.maxTrips) || !readValue(in, end, timeCount)) {
+        return false;
+    }
+    options_.departureTimes.resize(timeCount);
+    for (auto&& time: options_.departureTimes) {
+        if (!readValue(in, end, time)) return false;
+    }
+    if (options_.tileSize == 0 || options_.shardSize == 0) return false;
+    checkpointFile_ = filename + ".done";
+    return true;
+}
+
+std::pair<size_t, size_t> TravelTimeMatrix::getShardRows(size_t shard) const {
+    auto&& first = shard * options_.shardSize;
+    return {first, std::min<size_t>(first + options_.shardSize, getPaddedCount())};
+}
+
+size_t TravelTimeMatrix::getCellIndex(size_t row, size_t column) const {
+    size_t tile = options_.tileSize;
+    auto&& tilesPerRow = getPaddedCount() / tile;
+    return ((row / tile * tilesPerRow + column / tile) * tile + row % tile) * tile + column % tile;
+}
+
+size_t TravelTimeMatrix::getOffset(size_t time, size_t row) const {
+    auto&& padded = getPaddedCount();
+    return DATA_OFFSET + (time * padded + row) * padded * sizeof(uint16_t);
+}
+
+std::vector<bool> TravelTimeMatrix::readCheckpoint() const {
+    std::vector<bool> finished(getShardCount());
+    std::ifstream in{checkpointFile_, std::ios::binary};
+    for (CheckpointRecord record; in.read(reinterpret_cast<char*>(&record), sizeof(record));) {
+        if (record.jobId == jobId_ && record.shard < finished.size()) finished[record.shard] = true;
+    }
+    return finished;
+}
+
+std::vector<uint16_t> TravelTimeMatrix::computeShard(Timetable& timetable, size_t shard) const {
+    auto&& [first, last] = getShardRows(shard);
+    auto&& padded = getPaddedCount();
+    auto&& times = options_.departureTimes;
+    std::vector<uint16_t> travelTimes(times.size() * (last - first) * padded, UNREACHABLE);
+
+    // original id -> stop
+    std::vector<Stop*> stops(stopCount_);
+    for (auto&& [_, stop]: timetable.getStops()) {
+        if (stop.getOriginalId() < stops.size()) stops[stop.getOriginalId()] = &stop;
+    }
+
+    Query query;
+    query.maxTrips = options_.maxTrips;
+    for (size_t origin = first; origin < std::min<size_t>(last, stopCount_); ++origin) {
+        if (stops[origin] == nullptr) continue;
+        query.access = {{stops[origin], 0}};
+        for (size_t time = 0; time < times.size(); ++time) {
+            // no target, so the search isn't pruned and reaches all stops
+            query.startTime = times[time];
+            Raptor raptor{timetable, query};
+            raptor.raptor(true);
+
+            auto&& matrix = travelTimes.data() + time * (last - first) * padded;
+            for (size_t destination = 0; destination < stopCount_; ++destination) {
+                if (stops[destination] == nullptr) continue;
+                auto&& arrival = raptor.getEarliestTime(*stops[destination]);
+                if (arrival == SIZE_MAX) continue;
+
+                // whole minutes rounded up
+                auto&& minutes = (arrival - times[time] + 59) / 60;
+                matrix[getCellIndex(origin - first, destination)] =
+                    static_cast<uint16_t>(std::min<size_t>(minutes, UNREACHABLE - 1));
+            }
+        }
+    }
+    return travelTimes;
+}
+
+bool TravelTimeMatrix::writeShard(size_t shard, const std::vector<uint16_t>& travelTimes) {
+    auto&& [first, last] = getShardRows(shard);
+    auto&& size = (last - first) * getPaddedCount();
+    bool ok = travelTimes.size() == options_.departureTimes.size() * size;
+    for (size_t time = 0; ok && time < options_.departureTimes.size(); ++time) {
+        ok = writeAll(fd_, reinterpret_cast<const char*>(travelTimes.data() + time * size), size * sizeof(uint16_t),
+                      getOffset(time, first));
+    }
+
+    // the shard is recorded only when its data can't be lost
+    ok = ok && fsync(fd_) == 0;
+    if (ok) {
+        CheckpointRecord record{jobId_, shard};
+        int fd = ::open(checkpointFile_.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        ok = fd >= 0 && write(fd, &record, sizeof(record)) == static_cast<ssize_t>(sizeof(record)) && fsync(fd) == 0;
+        if (fd >= 0) ::close(fd);
+    }
+    if (!ok) std::cout << "Can't write shard " << shard << '\n';
+    return ok;
+}
+
+uint16_t TravelTimeMatrix::getTravelTime(size_t time, size_t origin, size_t destination) const {
+    uint16_t travelTime = UNREACHABLE;
+    if (time >= options_.departureTimes.size() || origin >= stopCount_ || destination >= stopCount_) {
+        return travelTime;
+    }
+    auto&& offset = getOffset(time, 0) + getCellIndex(origin, destination) * sizeof(uint16_t);
+    if (!readAll(fd_, reinterpret_cast<char*>(&travelTime), sizeof(travelTime), offset)) return UNREACHABLE;
+    return travelTime;
+}
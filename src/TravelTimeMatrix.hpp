@@ -0,0 +1,123 @@
+#ifndef TRAVELTIMEMATRIX_HPP_
+#define TRAVELTIMEMATRIX_HPP_
+
+#include "Timetable.hpp"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// stop-to-stop travel times in minutes for several departure times, computed by one-to-all raptor searches
+// in shards of origins, every finished shard is written into the matrix file and recorded in a checkpoint,
+// so a killed job continues with the unfinished shards and several processes can share one matrix
+//
+// file (native byte order):
+//   header - magic "TTMX", version, job id (u64), fingerprint of the timetable (u64), stop count, tile size,
+//   shard size, max trips, number of departure times (u32) and the departure times (u32 seconds)
+//   data from DATA_OFFSET - for every departure time a matrix of origins x destinations (original stop ids)
+//   padded to whole tiles, stored by tiles (row by row) of tile size x tile size uint16 minutes (row major),
+//   UNREACHABLE if the destination can't be reached (or there is no stop with the id),
+//   zeros in the shards not recorded in the checkpoint yet
+// checkpoint (the filename + ".done") - records (job id, shard) of the shards written into the matrix
+class TravelTimeMatrix {
+public:
+    struct Options {
+        // departure times from the origins (seconds)
+        std::vector<uint32_t> departureTimes;
+
+        uint32_t maxTrips = Query::DEFAULT_MAX_TRIPS;
+
+        // origins (and destinations) in a tile
+        uint32_t tileSize = 64;
+
+        // origins in a shard (rounded up to whole tiles)
+        uint32_t shardSize = 256;
+    };
+
+    // travel time to the destinations that can't be reached
+    static constexpr uint16_t UNREACHABLE = UINT16_MAX;
+
+    TravelTimeMatrix() = default;
+    ~TravelTimeMatrix();
+
+    TravelTimeMatrix(const TravelTimeMatrix&) = delete;
+    TravelTimeMatrix& operator=(const TravelTimeMatrix&) = delete;
+
+    // open the matrix of timetable computed with options, a new one is created if the file doesn't exist,
+    // returns false if it was created for another timetable or with other options
+    bool open(const std::string& filename, Timetable& timetable, const Options& options);
+
+    // open an existing matrix for reading
+    bool open(const std::string& filename);
+
+    // origins and destinations are lower than this number (the highest original stop id + 1)
+    [[nodiscard]]
+    size_t getStopCount() const { return stopCount_; }
+
+    [[nodiscard]]
+    const Options& getOptions() const { return options_; }
+
+    [[nodiscard]]
+    size_t getShardCount() const { return (getPaddedCount() + options_.shardSize - 1) / options_.shardSize; }
+
+    // rows of shard [first, last), the last shard may end with the padding
+    [[nodiscard]]
+    std::pair<size_t, size_t> getShardRows(size_t shard) const;
+
+    // shards recorded in the checkpoint (by any process)
+    [[nodiscard]]
+    std::vector<bool> readCheckpoint() const;
+
+    // travel times from the origins of shard as they are stored (by departure times and tiles),
+    // timetable is the one the matrix was opened for or a copy of it
+    [[nodiscard]]
+    std::vector<uint16_t> computeShard(Timetable& timetable, size_t shard) const;
+
+    // write the travel times of shard and record it in the checkpoint when they are on the disk,
+    // can be called from several threads at once
+    bool writeShard(size_t shard, const std::vector<uint16_t>& travelTimes);
+
+    // travel time in minutes from origin to destination (original stop ids) departing at departureTimes[time]
+    [[nodiscard]]
+    uint16_t getTravelTime(size_t time, size_t origin, size_t destination) const;
+
+    // the header and the departure times fit in, the data start at the page boundary
+    static constexpr size_t DATA_OFFSET = 4096;
+
+private:
+    // the stop count rounded up to whole tiles
+    [[nodiscard]]
+    size_t getPaddedCount() const {
+        return (stopCount_ + options_.tileSize - 1) / options_.tileSize * options_.tileSize;
+    }
+
+    // index of the cell in the rows of the matrix (of one departure time) starting at a tile boundary
+    [[nodiscard]]
+    size_t getCellIndex(size_t row, size_t column) const;
+
+    // file position of the rows starting at row for the time
+    [[nodiscard]]
+    size_t getOffset(size_t time, size_t row) const;
+
+    bool readHeader(const std::string& filename);
+
+    // create the file with the header (atomically, another process may be creating it too)
+    bool create(const std::string& filename);
+
+    void close();
+
+    int fd_ = -1;
+    std::string checkpointFile_;
+
+    // random id of the matrix file, the records of other (deleted) matrices in the checkpoint are ignored
+    uint64_t jobId_ = 0;
+    uint64_t fingerprint_ = 0;
+    uint32_t stopCount_ = 0;
+    Options options_;
+
+    static constexpr uint32_t MAGIC = 0x584D5454; // "TTMX"
+    static constexpr uint32_t VERSION = 1;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "TripBased.hpp"
+
+#include <algorithm>
+
+void TripBased::enqueue(Trip* trip, uint32_t i, uint32_t parent, uint32_t parentExit) {
+    auto&& firstReached = reached_[trip->getId()];
+    if (i >= firstReached) return;
+
+    auto&& stopCount = static_cast<uint32_t>(trip->getRoute()->getStops().size());
+    queue_.push_back({trip, i, std::min(firstReached, stopCount), parent, parentExit});
+
+    // all later trips of the lane are reached from i as well
+    for (auto&& later: tripTransfers_->getLaterTrips(trip)) {
+        auto&& r = reached_[later->getId()];
+        if (r <= i) break;
+        r = i;
+    }
+}
+
+void TripBased::enqueueStartTrips() {
+    auto&& tripTransfers = *tripTransfers_;
+
+    for (auto&& [stop, offset]: query_.access) {
+        size_t time = startTime_ + offset;
+        for (auto&& [route, i]: tripTransfers.getStopRoutes(stop)) {
+            // the first trip of every lane, a trip of another lane may overtake it
+            auto&& routeTrips = schedule_->getTrips(*route);
+            for (size_t lane = 0; lane < routeTrips.getLaneCount(); ++lane) {
+                auto&& tripTimes = routeTrips.getTimes(lane);
+                auto isBefore = [i](auto&& times, size_t time) {
+                    return time > times.getDepartureTime(i);
+                };
+                auto it = std::lower_bound(tripTimes.begin(), tripTimes.end(), time, isBefore);
+                if (it != tripTimes.end()) enqueue(routeTrips.getTrips(lane)[it - tripTimes.begin()], i, NO_PARENT, 0);
+            }
+        }
+    }
+}
+
+void TripBased::findDestinationRoutes() {
+    auto&& tripTransfers = *tripTransfers_;
+    destinationRoutes_.clear();
+    minEgressOffset_ = SIZE_MAX;
+
+    auto addRoutes = [&](const Stop* stop, size_t offset) {
+        for (auto&& [route, i]: tripTransfers.getStopRoutes(stop)) destinationRoutes_.push_back({route, i, offset});
+    };
+    for (auto&& [stop, offset]: query_.egress) {
+        minEgressOffset_ = std::min(minEgressOffset_, offset);
+        addRoutes(stop, offset);
+
+        // walk to the egress stop from the stops around
+        for (auto&& from: tripTransfers.getFootpaths(stop)) addRoutes(from, offset + TripTransfers::TRANSFER_TIME);
+    }
+    std::ranges::sort(destinationRoutes_, {}, &Destination::route);
+}
+
+void TripBased::search() {
+    auto&& tripTransfers = *tripTransfers_;
+    reached_.assign(tripTransfers.getTripCount(), UINT32_MAX);
+    queue_.clear();
+    arrivalTime_ = SIZE_MAX;
+    lastSegment_ = NO_PARENT;
+    startLimits();
+
+    // the target can't be reached at all
+    findDestinationRoutes();
+    if (destinationRoutes_.empty()) return;
+    enqueueStartTrips();
+
+    size_t roundBegin = 0;
+    for (size_t k = 0; k < numberOfTrips_ && roundBegin < queue_.size(); ++k) {
+        auto&& roundEnd = queue_.size();
+
+        // check if the segments arrive at the destination
+        for (size_t s = roundBegin; s < roundEnd; ++s) {
+            auto&& [trip, from, to, _parent, _exit] = queue_[s];
+            auto&& [first, last] = std::ranges::equal_range(destinationRoutes_, trip->getRoute(), {},
+                                                            &Destination::route);
+            for (auto&& it = first; it != last; ++it) {
+                if (it->stopIndex <= from || it->stopIndex >= to) continue;
+
+                size_t arrivalTime = tripTransfers.getTimes(trip).getArrivalTime(it->stopIndex) + it->offset;
+                if (arrivalTime < arrivalTime_) {
+                    arrivalTime_ = arrivalTime;
+                    lastSegment_ = static_cast<uint32_t>(s);
+                    lastExit_ = it->stopIndex;
+                }
+            }
+        }
+
+        // no more trips can be used in the last round
+        if (k + 1 == numberOfTrips_) break;
+
+        // transfer to the next trips
+        for (size_t s = roundBegin; s < roundEnd; ++s) {
+            // the segments found so far stay valid, the next round just won't be complete
+            if (stopSearch()) return;
+
+            // copy, enqueue may reallocate the queue
+            auto [trip, from, to, _parent, _exit] = queue_[s];
+            auto&& times = tripTransfers.getTimes(trip);
+            for (uint32_t i = from + 1; i < to; ++i) {
+
+                // target pruning - every trip boarded later arrives later
+                if (times.getArrivalTime(i) + TripTransfers::CHANGE_TIME + minEgressOffset_ >= arrivalTime_) break;
+
+                for (auto&& transfer: tripTransfers.getTransfers(trip, i)) {
+                    enqueue(tripTransfers.getTrip(transfer.trip), transfer.stopIndex, static_cast<uint32_t>(s), i);
+                }
+            }
+        }
+        roundBegin = roundEnd;
+        if (roundBegin < queue_.size() && checkLimits()) return;
+    }
+}
+
+Journey TripBased::getJourney() const {
+    Journey journey;
+    journey.setComplete(!isInterrupted());
+    if (lastSegment_ == NO_PARENT) return journey;
+    journey.setArrivalTime(arrivalTime_);
+
+    auto exit = lastExit_;
+    for (auto s = lastSegment_; s != NO_PARENT;) {
+        auto&& segment = queue_[s];
+        journey.addLeg(createLeg(segment.trip, segment.from, exit));
+        exit = segment.parentExit;
+        s = segment.parent;
+    }
+
+    // legs are filled from end to start, reverse the order
+    journey.reverse();
+    return journey;
+}
@@ -0,0 +1,85 @@
+#ifndef TRIPBASED_HPP_
+#define TRIPBASED_HPP_
+
+#include "SearchEngine.hpp"
+
+#include <algorithm>
+
+// earliest arrival search using the precomputed trip-to-trip transfers
+// (Timetable::computeTripTransfers or Timetable::loadTripTransfers must be called first)
+// the results are the same as the results of the raptor algorithm
+class TripBased : public SearchEngine {
+public:
+    TripBased(Timetable& t, const Query& query) : TripBased(t, query, t.getTripTransfers()) {}
+
+    // run the Trip-Based search
+    void search() override;
+
+    // get the resulting connection - sequence of trips with boarding and exit stops
+    [[nodiscard]]
+    Journey getJourney() const override;
+
+private:
+    // search tripTransfers (with their schedule) for the whole run
+    TripBased(Timetable& t, const Query& query, std::shared_ptr<const TripTransfers> tripTransfers)
+        : SearchEngine(t, query, tripTransfers->getSchedule()), tripTransfers_(std::move(tripTransfers)),
+          numberOfTrips_(std::clamp<size_t>(query.maxTrips, 1, Journey::MAX_LEGS)), startTime_(query.startTime) {}
+
+    // part of a trip reachable in some round, stops [from, to) of the trip
+    struct Segment {
+        Trip* trip;
+        uint32_t from;
+        uint32_t to;
+
+        // segment from which we transferred to this one and the exit stop on it
+        uint32_t parent;
+        uint32_t parentExit;
+    };
+
+    // add segment of trip starting at stop index i to the queue (if not reached yet)
+    void enqueue(Trip* trip, uint32_t i, uint32_t parent, uint32_t parentExit);
+
+    // route arriving at a stop from which the target is reached after offset
+    struct Destination {
+        Route* route;
+        uint32_t stopIndex;
+        size_t offset;
+    };
+
+    // add segments of all trips that can be boarded at the access stops
+    void enqueueStartTrips();
+
+    // find routes (and stop indices) that arrive at the egress stops (or walk to them)
+    void findDestinationRoutes();
+
+    static constexpr uint32_t NO_PARENT = UINT32_MAX;
+
+    // trip transfers of the timetable when the engine was created
+    const std::shared_ptr<const TripTransfers> tripTransfers_;
+
+    // max number of trips used in the search
+    const size_t numberOfTrips_;
+
+    const size_t startTime_;
+
+    // trip id -> first stop index of the trip already reached
+    std::vector<uint32_t> reached_;
+
+    // segments of all rounds
+    std::vector<Segment> queue_;
+
+    // routes that arrive at the destination sorted by route
+    std::vector<Destination> destinationRoutes_;
+
+    // the lowest offset of the egress stops (lower bound for target pruning)
+    size_t minEgressOffset_ = SIZE_MAX;
+
+    // the earliest arrival time at the destination
+    size_t arrivalTime_ = SIZE_MAX;
+
+    // the last segment of the resulting connection and its exit stop index
+    uint32_t lastSegment_ = NO_PARENT;
+    uint32_t lastExit_ = 0;
+};
+
+#endif
@@ -0,0 +1,283 @@
+#include "TripTransfers.hpp"
+#include "Timetable.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <thread>
+
+namespace {
+
+// number of trips taken by a thread at once
+constexpr size_t TRIPS_CHUNK = 64;
+
+template<typename T>
+void writeValue(std::ostream& out, const T& value) {
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool readValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template<typename T>
+void writeVector(std::ostream& out, const std::vector<T>& v) {
+    writeValue(out, static_cast<uint64_t>(v.size()));
+    out.write(reinterpret_cast<const char*>(v.data()), static_cast<std::streamsize>(v.size() * sizeof(T)));
+}
+
+template<typename T>
+bool readVector(std::istream& in, std::vector<T>& v) {
+    uint64_t size;
+    if (!readValue(in, size)) return false;
+    v.resize(size);
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(v.data()), static_cast<std::streamsize>(size * sizeof(T))));
+}
+
+}
+
+void TripTransfers::buildIndices(Timetable& timetable) {
+    timetable_ = &timetable;
+    schedule_ = timetable.getSchedule();
+
+    size_t stopCount = timetable.getStopCount();
+    size_t tripCount = 0;
+    for (auto&& [id, _]: timetable.getTrips()) tripCount = std::max(tripCount, id + 1);
+
+    trips_.assign(tripCount, nullptr);
+    times_.assign(tripCount, nullptr);
+    tripPositions_.assign(tripCount, 0);
+    laterTrips_.assign(tripCount, nullptr);
+    laneEnds_.assign(tripCount, nullptr);
+    for (auto&& [id, trip]: timetable.getTrips()) trips_[id] = &trip;
+
+    // routes sorted by id, so that the indices don't depend on the hash table order
+    std::vector<Route*> routes;
+    for (auto&& [_, route]: timetable.getRoutes()) routes.emplace_back(&route);
+    std::ranges::sort(routes, {}, &Route::getId);
+
+    for (auto&& route: routes) {
+        auto&& routeTrips = schedule_->getTrips(*route);
+        auto&& trips = routeTrips.getTrips();
+        for (size_t pos = 0; pos < trips.size(); ++pos) {
+            auto&& id = trips[pos]->getId();
+            times_[id] = &routeTrips.getTimes()[pos];
+            tripPositions_[id] = static_cast<uint32_t>(pos);
+            laterTrips_[id] = trips.data() + pos;
+            laneEnds_[id] = trips.data() + routeTrips.getLaneEnd(routeTrips.getLane(static_cast<uint32_t>(pos)));
+        }
+    }
+
+    // stop events of every trip
+    eventOffsets_.assign(tripCount + 1, 0);
+    for (size_t id = 0; id < tripCount; ++id) {
+        size_t length = trips_[id] != nullptr ? trips_[id]->getRoute()->getStops().size() : 0;
+        eventOffsets_[id + 1] = eventOffsets_[id] + static_cast<uint32_t>(length);
+    }
+
+    // routes of every stop
+    stopRouteOffsets_.assign(stopCount + 1, 0);
+    for (auto&& route: routes) {
+        for (auto&& stop: route->getStops()) ++stopRouteOffsets_[stop->getId() + 1];
+    }
+    for (size_t id = 0; id < stopCount; ++id) stopRouteOffsets_[id + 1] += stopRouteOffsets_[id];
+
+    stopRoutes_.resize(stopRouteOffsets_.back());
+    std::vector<uint32_t> filled(stopRouteOffsets_.begin(), stopRouteOffsets_.end() - 1);
+    for (auto&& route: routes) {
+        auto&& stops = route->getStops();
+        for (size_t j = 0; j < stops.size(); ++j) {
+            stopRoutes_[filled[stops[j]->getId()]++] = {route, static_cast<uint32_t>(j)};
+        }
+    }
+
+    // walking transfers of every stop
+    std::vector<Stop*> stops(stopCount);
+    for (auto&& [_, stop]: timetable.getStops()) stops[stop.getId()] = &stop;
+    footpathOffsets_.assign(stopCount + 1, 0);
+    footpaths_.clear();
+    for (size_t id = 0; id < stopCount; ++id) {
+        if (stops[id] != nullptr) {
+            if (auto&& it = timetable.getTransfers().find(stops[id]); it != timetable.getTransfers().end()) {
+                std::ranges::copy(it->second, std::back_inserter(footpaths_));
+            }
+        }
+        footpathOffsets_[id + 1] = static_cast<uint32_t>(footpaths_.size());
+    }
+}
+
+void TripTransfers::computeTripTransfers(Trip* trip, std::vector<size_t>& arrivalTimes,
+                                         std::vector<uint32_t>& touched,
+                                         std::vector<std::pair<uint32_t, TripTransfer>>& result) const {
+    auto&& route = trip->getRoute();
+    auto&& stops = route->getStops();
+    auto&& times = getTimes(trip);
+    auto&& tripPosition = getTripPosition(trip);
+    auto&& tripLane = schedule_->getTrips(*route).getLane(tripPosition);
+
+    // improve the earliest arrival time at stop
+    auto improve = [&](const Stop* stop, size_t time) {
+        auto&& id = stop->getId();
+        if (time >= arrivalTimes[id]) return false;
+        if (arrivalTimes[id] == SIZE_MAX) touched.emplace_back(id);
+        arrivalTimes[id] = time;
+        return true;
+    };
+
+    // improve the earliest arrival time at stop and all stops in walking distance
+    auto improveWithWalk = [&](const Stop* stop, size_t time) {
+        bool improved = improve(stop, time);
+        for (auto&& to: getFootpaths(stop)) improved |= improve(to, time + TRANSFER_TIME);
+        return improved;
+    };
+
+    // stops are scanned from the last one, so the arrival times already contain
+    // everything reachable by staying on trip or by transferring later
+    for (size_t i = stops.size() - 1; i > 0; --i) {
+        improveWithWalk(stops[i], times.getArrivalTime(i));
+
+        // transfer to the first trip of lane of r departing from its j-th stop at boardingTime or later
+        auto transferTo = [&](const Route* r, size_t lane, uint32_t j, size_t boardingTime) {
+            auto&& rStops = r->getStops();
+            auto&& routeTrips = schedule_->getTrips(*r);
+            auto&& tripTimes = routeTrips.getTimes(lane);
+            auto isBefore = [j](auto&& uTimes, size_t time) {
+                return time > uTimes.getDepartureTime(j);
+            };
+            auto it = std::lower_bound(tripTimes.begin(), tripTimes.end(), boardingTime, isBefore);
+            if (it == tripTimes.end()) return;
+            auto&& position = routeTrips.getLaneBegin(lane) + static_cast<uint32_t>(it - tripTimes.begin());
+            Trip* u = routeTrips.getTrips()[position];
+
+            // staying on trip is always at least as good (the later trips of its lane don't arrive earlier)
+            if (r == route && lane == tripLane && position >= tripPosition && j >= i) return;
+
+            // u-turn - the same trip could be boarded one stop earlier
+            if (rStops[j + 1] == stops[i - 1] &&
+                times.getArrivalTime(i - 1) + CHANGE_TIME <= it->getDepartureTime(j + 1)) {
+                return;
+            }
+
+            // keep the transfer only if it improves the arrival at some stop
+            bool keep = false;
+            for (size_t k = j + 1; k < rStops.size(); ++k) {
+                keep |= improveWithWalk(rStops[k], it->getArrivalTime(k));
+            }
+            if (keep) result.emplace_back(static_cast<uint32_t>(i), TripTransfer{static_cast<uint32_t>(u->getId()), j});
+        };
+
+        // transfers to all routes at stop (after walking walkTime)
+        auto transfersAt = [&](const Stop* stop, size_t walkTime) {
+            size_t boardingTime = times.getArrivalTime(i) + walkTime + CHANGE_TIME;
+
+            for (auto&& [r, j]: getStopRoutes(stop)) {
+                // can't ride anywhere from the last stop
+                if (j + 1 >= r->getStops().size()) continue;
+
+                for (size_t lane = 0; lane < schedule_->getTrips(*r).getLaneCount(); ++lane) {
+                    transferTo(r, lane, j, boardingTime);
+                }
+            }
+        };
+
+        transfersAt(stops[i], 0);
+        for (auto&& to: getFootpaths(stops[i])) transfersAt(to, TRANSFER_TIME);
+    }
+
+    // transfers were found from the last stop
+    std::ranges::reverse(result);
+}
+
+void TripTransfers::compute(Timetable& timetable, size_t threadCount) {
+    buildIndices(timetable);
+
+    if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // transfers of every trip, indexed by the trip id
+    std::vector<std::vector<std::pair<uint32_t, TripTransfer>>> tripTransfers(trips_.size());
+    std::atomic<size_t> nextTrip{0};
+
+    auto worker = [&]() {
+        std::vector<size_t> arrivalTimes(getStopCount(), SIZE_MAX);
+        std::vector<uint32_t> touched;
+
+        for (size_t first; (first = nextTrip.fetch_add(TRIPS_CHUNK)) < trips_.size();) {
+            for (size_t id = first; id < std::min(first + TRIPS_CHUNK, trips_.size()); ++id) {
+                if (trips_[id] == nullptr) continue;
+                computeTripTransfers(trips_[id], arrivalTimes, touched, tripTransfers[id]);
+
+                // reset only the stops changed by this trip
+                for (auto&& stop: touched) arrivalTimes[stop] = SIZE_MAX;
+                touched.clear();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; ++i) threads.emplace_back(worker);
+    worker();
+    for (auto&& thread: threads) thread.join();
+
+    // merge into the flat layout
+    transferOffsets_.assign(eventOffsets_.back() + 1, 0);
+    transfers_.clear();
+    for (size_t id = 0; id < trips_.size(); ++id) {
+        for (auto&& [i, transfer]: tripTransfers[id]) {
+            ++transferOffsets_[eventOffsets_[id] + i + 1];
+            transfers_.emplace_back(transfer);
+        }
+        tripTransfers[id] = {};
+    }
+    for (size_t event = 0; event + 1 < transferOffsets_.size(); ++event) {
+        transferOffsets_[event + 1] += transferOffsets_[event];
+    }
+}
+
+bool TripTransfers::save(std::ostream& out) const {
+    if (empty() || schedule_->hasDelays()) return false;
+    writeValue(out, MAGIC);
+    writeValue(out, VERSION);
+    writeValue(out, timetable_->getFingerprint());
+    writeVector(out, eventOffsets_);
+    writeVector(out, transferOffsets_);
+    writeVector(out, transfers_);
+    return static_cast<bool>(out);
+}
+
+bool TripTransfers::load(std::istream& in, Timetable& timetable) {
+    uint32_t magic, version;
+    uint64_t fingerprint;
+    if (!readValue(in, magic) || magic != MAGIC) return false;
+    if (!readValue(in, version) || version != VERSION) return false;
+    if (!readValue(in, fingerprint) || fingerprint != timetable.getFingerprint()) return false;
+
+    // the transfers were computed from the scheduled times
+    if (timetable.getSchedule()->hasDelays()) return false;
+
+    std::vector<uint32_t> eventOffsets;
+    if (!readVector(in, eventOffsets) || !readVector(in, transferOffsets_) || !readVector(in, transfers_)) {
+        transferOffsets_.clear();
+        transfers_.clear();
+        return false;
+    }
+
+    buildIndices(timetable);
+    if (eventOffsets != eventOffsets_ || transferOffsets_.size() != eventOffsets_.back() + 1 ||
+        transferOffsets_.back() != transfers_.size()) {
+        transferOffsets_.clear();
+        transfers_.clear();
+        return false;
+    }
+    return true;
+}
+
+size_t TripTransfers::getMemoryUsage() const {
+    return eventOffsets_.capacity() * sizeof(uint32_t) + transferOffsets_.capacity() * sizeof(uint32_t) +
+        transfers_.capacity() * sizeof(TripTransfer) + trips_.capacity() * sizeof(Trip*) +
+        times_.capacity() * sizeof(const TripTimes*) + laterTrips_.capacity() * sizeof(Trip* const*) +
+        laneEnds_.capacity() * sizeof(Trip* const*) +
+        tripPositions_.capacity() * sizeof(uint32_t) + stopRouteOffsets_.capacity() * sizeof(uint32_t) +
+        stopRoutes_.capacity() * sizeof(StopRoute) + footpathOffsets_.capacity() * sizeof(uint32_t) +
+        footpaths_.capacity() * sizeof(Stop*);
+}
@@ -0,0 +1,163 @@
+#ifndef TRIPTRANSFERS_HPP_
+#define TRIPTRANSFERS_HPP_
+
+#include "DataTypes.hpp"
+#include "Schedule.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <vector>
+
+class Timetable;
+
+// transfer from a stop event of one trip to a stop event of another trip
+struct TripTransfer {
+    uint32_t trip;
+    uint32_t stopIndex;
+};
+
+// route serving a stop and the index of the stop along the route
+struct StopRoute {
+    Route* route;
+    uint32_t stopIndex;
+};
+
+// reduced trip-to-trip transfers used by the Trip-Based routing
+// (Witt, Trip-Based Public Transit Routing, 2015)
+// transfers are stored per stop event in a flat (CSR) layout
+class TripTransfers {
+public:
+    // change trip at the exact same stop, same as in the raptor algorithm
+    static constexpr size_t CHANGE_TIME = 30;
+
+    // transfer/walk to another stop, same as in the raptor algorithm
+    static constexpr size_t TRANSFER_TIME = 120;
+
+    // compute all transfers of the current schedule of the timetable and reduce them,
+    // trips are split between threadCount threads (0 = hardware concurrency)
+    void compute(Timetable& timetable, size_t threadCount=0);
+
+    // write the transfers, fails if they weren't computed or they were computed with delays
+    bool save(std::ostream& out) const;
+
+    // read the transfers computed for this timetable,
+    // fails if the data were computed for a different timetable or some trips of the timetable are delayed
+    bool load(std::istream& in, Timetable& timetable);
+
+    [[nodiscard]]
+    bool empty() const { return transferOffsets_.empty(); }
+
+    // number of all transfers
+    [[nodiscard]]
+    size_t size() const { return transfers_.size(); }
+
+    // get transfers from the i-th stop of trip
+    [[nodiscard]]
+    std::span<const TripTransfer> getTransfers(const Trip* trip, size_t i) const {
+        auto event = eventOffsets_[trip->getId()] + i;
+        return {transfers_.data() + transferOffsets_[event], transfers_.data() + transferOffsets_[event + 1]};
+    }
+
+    // get all routes serving stop (with the index of the stop along the route)
+    [[nodiscard]]
+    std::span<const StopRoute> getStopRoutes(const Stop* stop) const {
+        auto id = stop->getId();
+        return {stopRoutes_.data() + stopRouteOffsets_[id], stopRoutes_.data() + stopRouteOffsets_[id + 1]};
+    }
+
+    // get stops in walking distance from stop
+    [[nodiscard]]
+    std::span<Stop* const> getFootpaths(const Stop* stop) const {
+        auto id = stop->getId();
+        return {footpaths_.data() + footpathOffsets_[id], footpaths_.data() + footpathOffsets_[id + 1]};
+    }
+
+    [[nodiscard]]
+    Trip* getTrip(uint32_t id) const { return trips_[id]; }
+
+    // times of trip in the schedule of the transfers
+    [[nodiscard]]
+    const TripTimes& getTimes(const Trip* trip) const { return *times_[trip->getId()]; }
+
+    // trip and the trips after it in its lane of the schedule (sorted by departure time)
+    [[nodiscard]]
+    std::span<Trip* const> getLaterTrips(const Trip* trip) const {
+        auto&& id = trip->getId();
+        return {laterTrips_[id], laneEnds_[id]};
+    }
+
+    // position of trip in the trips of its route in the schedule (see RouteTrips)
+    [[nodiscard]]
+    uint32_t getTripPosition(const Trip* trip) const { return tripPositions_[trip->getId()]; }
+
+    // schedule from which the transfers were computed (or loaded)
+    [[nodiscard]]
+    const std::shared_ptr<const Schedule>& getSchedule() const { return schedule_; }
+
+    [[nodiscard]]
+    size_t getTripCount() const { return trips_.size(); }
+
+    // number of stops of the timetable
+    [[nodiscard]]
+    size_t getStopCount() const { return stopRouteOffsets_.empty() ? 0 : stopRouteOffsets_.size() - 1; }
+
+    // bytes used by the transfers and the indices
+    [[nodiscard]]
+    size_t getMemoryUsage() const;
+
+private:
+    // create indices that are not stored (trips by id, their times and positions, stop routes, footpaths)
+    // for the current schedule of timetable
+    void buildIndices(Timetable& timetable);
+
+    // find transfers from trip and reduce them, transfers are sorted by stop index
+    void computeTripTransfers(Trip* trip, std::vector<size_t>& arrivalTimes,
+                              std::vector<uint32_t>& touched,
+                              std::vector<std::pair<uint32_t, TripTransfer>>& result) const;
+
+    static constexpr uint32_t MAGIC = 0x52544254; // "TBTR"
+    static constexpr uint32_t VERSION = 1;
+
+    Timetable* timetable_ = nullptr;
+
+    std::shared_ptr<const Schedule> schedule_;
+
+    // trip id -> index of its first stop event
+    std::vector<uint32_t> eventOffsets_;
+
+    // stop event -> index of its first transfer
+    std::vector<uint32_t> transferOffsets_;
+
+    // transfers of all stop events
+    std::vector<TripTransfer> transfers_;
+
+    // trip id -> trip
+    std::vector<Trip*> trips_;
+
+    // trip id -> times of the trip in schedule_
+    std::vector<const TripTimes*> times_;
+
+    // trip id -> position in the trips of its route in schedule_
+    std::vector<uint32_t> tripPositions_;
+
+    // trip id -> the trip and the end of its lane in the trips of its route in schedule_
+    std::vector<Trip* const*> laterTrips_;
+    std::vector<Trip* const*> laneEnds_;
+
+    // stop id -> index of its first route
+    std::vector<uint32_t> stopRouteOffsets_;
+
+    // routes of all stops
+    std::vector<StopRoute> stopRoutes_;
+
+    // stop id -> index of its first footpath
+    std::vector<uint32_t> footpathOffsets_;
+
+    // footpaths of all stops
+    std::vector<Stop*> footpaths_;
+};
+
+#endif
@@ -1,7 +1,17 @@
 ﻿#include "Raptor.hpp"
 #include "InputReader.hpp"
+#include "Parsing.hpp"
+#include "QueryLog.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
 #include <iostream>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 
 // helper functions for debugging
 
@@ -9,44 +19,155 @@
 void printTransfers(Timetable& timetable) {
     for (auto&& [from, toStops]: timetable.getTransfers()) {
         for (auto&& to: toStops) {
-            std::cout << from->getId() << ' ' << from->getName() << " >> "
-                      << to->getId() << ' ' << to->getName() << std::endl;
+            std::cout << from->getId() << ' ' << timetable.getName(*from) << " >> "
+                      << to->getId() << ' ' << timetable.getName(*to) << std::endl;
         }
     }
 }
 
 [[maybe_unused]]
-void printEarliestTimes(Timetable& timetable) {
+void printEarliestTimes(Timetable& timetable, const Raptor& raptor) {
     for (auto&& [_, stop]: timetable.getStops()) {
-        if (stop.getEarliestTime() < SIZE_MAX) {
-            std::cout << stop.getId() << ' ' << stop.getName() << ' ' << Raptor::toTimeString(stop.getEarliestTime()) << std::endl;
+        if (raptor.getEarliestTime(stop) < SIZE_MAX) {
+            std::cout << stop.getId() << ' ' << timetable.getName(stop) << ' ' << Raptor::toTimeString(raptor.getEarliestTime(stop)) << std::endl;
         }
     }
 }
 
 [[maybe_unused]]
-void printKTimes(Timetable& timetable) {
+void printKTimes(Timetable& timetable, const Raptor& raptor, size_t numberOfTrips) {
     for (auto&& [_, stop]: timetable.getStops()) {
-        std::cout << stop.getId() << ' ' << stop.getName() << ' ';
-        for (auto&& ktime: stop.getArrTimesKTrips()) {
+        std::cout << stop.getId() << ' ' << timetable.getName(stop) << ' ';
+        for (size_t k = 0; k <= numberOfTrips; ++k) {
+            auto&& ktime = raptor.getArrivalTime(stop, k);
             std::cout << ((ktime == SIZE_MAX) ? "inf" : Raptor::toTimeString(ktime)) << ' ';
         }
         std::cout << std::endl;
     }
 }
 
-int main() {
+// print the departures of the board
+void printDepartures(Timetable& timetable, const Departures& board, std::span<const Departure> departures) {
+    for (auto&& departure: departures) {
+        auto&& trip = board.getTrip(departure.trip);
+        std::cout << Raptor::toTimeString(departure.time) << ' ' << timetable.getName(*trip->getRoute())
+                  << " >> " << timetable.getHeadsign(*trip)
+                  << " (stop " << board.getStop(departure.stop)->getOriginalId() << ")\n";
+    }
+}
+
+// set by ctrl+c, the search is stopped and the best connection found so far is printed
+std::atomic<bool> cancelled{false};
+
+extern "C" void cancelSearch(int /*signal*/) { cancelled.store(true, std::memory_order_relaxed); }
 
-    // try to make c++ streams faster
-    //std::ios_base::sync_with_stdio(false);
+int main(int argc, char* argv[]) {
+
+    // make c++ streams faster, the output is written by whole connections anyway
+    std::ios_base::sync_with_stdio(false);
+
+    // --json: print the connection as json instead of the human-readable text
+    // --engine raptor|trip-based|csa: search engine (raptor by default)
+    // --trip-based: use the Trip-Based search with precomputed trip transfers (same as --engine trip-based)
+    // --compress: store stop times of trips running the same pattern only once
+    // --max-trips N: use at most N trips (1 to 8, 5 by default)
+    // --renumber: renumber stops and routes for better locality
+    // --huge-pages none|transparent|explicit: store the arrays of stops and routes in one arena backed by the pages
+    // --delays FILE: apply the delays of trips from FILE (csv with trip_index,delay in seconds)
+    // --departures N: print the next N departures from a stop instead of searching
+    // --timeout MS: stop the search after MS milliseconds and print the best connection found so far
+    // --max-work N: stop the search after scanning N routes (raptor), trip segments or connections
+    // --log FILE: append the query and its result to the binary query log (see tools/ReplayLog)
+    bool json = false;
+    auto engine = EngineType::Raptor;
+    bool compress = false;
+    bool renumber = false;
+    std::optional<HugePages> hugePages;
+    size_t maxTrips = Query::DEFAULT_MAX_TRIPS;
+    size_t departureCount = 0;
+    std::string delaysFile;
+    std::optional<std::chrono::milliseconds> timeout;
+    size_t maxWork = SIZE_MAX;
+    std::string logFile;
+    // value of a numeric flag, an invalid value is reported and the usage is printed after the flags
+    bool validFlags = true;
+    auto number = [&](std::string_view s) {
+        auto&& value = parseNumber<size_t>(s);
+        if (!value) std::cout << "Invalid number " << s << '\n';
+        validFlags = validFlags && value;
+        return value.value_or(0);
+    };
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+        if (arg == "--json") json = true;
+        else if (arg == "--trip-based") engine = EngineType::TripBased;
+        else if (arg == "--engine" && i + 1 < argc) {
+            auto&& type = getEngineType(argv[++i]);
+            if (!type) {
+                std::cout << "Unknown engine " << argv[i] << '\n';
+                return 1;
+            }
+            engine = *type;
+        }
+        else if (arg == "--compress") compress = true;
+        else if (arg == "--renumber") renumber = true;
+        else if (arg == "--huge-pages" && i + 1 < argc) {
+            hugePages = getHugePages(argv[++i]);
+            if (!hugePages) {
+                std::cout << "Unknown huge pages " << argv[i] << '\n';
+                return 1;
+            }
+        }
+        else if (arg == "--max-trips" && i + 1 < argc) maxTrips = number(argv[++i]);
+        else if (arg == "--delays" && i + 1 < argc) delaysFile = argv[++i];
+        else if (arg == "--departures" && i + 1 < argc) departureCount = number(argv[++i]);
+        else if (arg == "--timeout" && i + 1 < argc) timeout = std::chrono::milliseconds{number(argv[++i])};
+        else if (arg == "--max-work" && i + 1 < argc) maxWork = number(argv[++i]);
+        else if (arg == "--log" && i + 1 < argc) logFile = argv[++i];
+    }
+    if (!validFlags) {
+        std::cout << "usage: JourneyPlanner [--json] [--engine NAME] [--compress] [--max-trips N] [--renumber] "
+                     "[--huge-pages MODE] [--delays FILE] [--departures N] [--timeout MS] [--max-work N] [--log FILE]\n";
+        return 1;
+    }
 
     std::cout << "Loading data...\n";
     Timetable timetable;
-    timetable.readCSVData();
+    if (!timetable.readCSVData(compress)) return 1;
+    if (renumber) timetable.renumber();
+    if (hugePages && !timetable.compact(*hugePages)) return 1;
     timetable.createTransfers();
+    timetable.createStopGrid();
+    if (!delaysFile.empty()) {
+        DelayFeed feed;
+        if (!feed.read(delaysFile)) return 1;
+        auto&& start = std::chrono::steady_clock::now();
+        auto&& delayedTrips = timetable.applyDelays(feed.getDelays());
+        std::chrono::duration<double, std::milli> duration = std::chrono::steady_clock::now() - start;
+        std::cout << "Delayed " << delayedTrips << " trips in " << duration.count() << " ms";
+        if (feed.getSkippedRowCount() != 0) std::cout << " (" << feed.getSkippedRowCount() << " rows skipped)";
+        std::cout << '\n';
+    }
+    if (engine == EngineType::ConnectionScan) timetable.createConnections();
+    if (departureCount != 0) timetable.createDepartures();
+    // the saved trip transfers are computed without delays
+    if (engine == EngineType::TripBased && (!delaysFile.empty() || !timetable.loadTripTransfers())) {
+        std::cout << "Computing trip transfers...\n";
+        timetable.computeTripTransfers();
+        if (delaysFile.empty() && !timetable.saveTripTransfers()) std::cout << "Can't save trip transfers\n";
+    }
+    timetable.printMemoryUsage(std::cout);
 
     // read input from user
-    InputReader reader{timetable.getStops()};
+    InputReader reader{timetable};
+    if (departureCount != 0) {
+        reader.readBoard();
+        auto&& stops = timetable.getStopsByName(reader.getStartName());
+        auto&& time = Raptor::toSeconds(reader.getStartTime());
+        auto&& board = timetable.getDepartures();
+        printDepartures(timetable, *board, board->getNextDepartures(stops, time, departureCount));
+        return 0;
+    }
     reader.read();
     auto&& startName = reader.getStartName();
     auto&& endName = reader.getEndName();
@@ -56,11 +177,29 @@ int main() {
     //auto&& endName = "Malostranske namesti";
     //size_t startTime = Raptor::toSeconds("8");
 
-    auto&& [startStop, endStop] = timetable.createArtificialStops(startName, endName);
-    Raptor r{timetable, startStop, endStop, startTime};
+    auto&& query = timetable.createQuery(startName, endName, startTime);
+    query.maxTrips = maxTrips;
+    query.limits.maxWork = maxWork;
+    query.limits.cancelled = &cancelled;
+    std::signal(SIGINT, cancelSearch);
 
     // search
-    r.raptor();
-    r.printConnection(true);
+    auto&& search = createEngine(engine, timetable, query);
+    auto&& start = std::chrono::steady_clock::now();
+    if (timeout) query.limits.deadline = start + *timeout;
+    search->search();
+    auto&& searchTime = std::chrono::steady_clock::now() - start;
+    if (json) search->printJson();
+    else search->printConnection(true);
+
+    if (!logFile.empty()) {
+        // the values the search really used, so the replay runs the same search
+        QueryRecord record{startName, endName, static_cast<uint32_t>(startTime), engine,
+                           static_cast<uint8_t>(std::clamp<size_t>(maxTrips, 1, Raptor::MAX_TRIPS)), maxWork,
+                           timeout ? static_cast<uint32_t>(std::min<int64_t>(timeout->count(), UINT32_MAX)) : 0};
+        record.setResult(search->getJourney(), searchTime);
+        QueryLog log;
+        if (!log.open(logFile) || !log.write(record)) return 1;
+    }
 }
 
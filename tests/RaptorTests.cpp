@@ -0,0 +1,1219 @@
+#include "ReferenceSearch.hpp"
+#include "Raptor.hpp"
+#include "JourneyFormatter.hpp"
+#include "GtfsConverter.hpp"
+#include "QueryLog.hpp"
+#include "TravelTimeMatrix.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numbers>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// number of random queries on the real data
+constexpr size_t RANDOM_QUERY_COUNT = 2000;
+
+// fixed seed, so that the failures can be reproduced
+constexpr unsigned RANDOM_SEED = 20240601;
+
+constexpr size_t DAY_SECONDS = 86400;
+
+size_t failures = 0;
+
+#define CHECK(condition) check((condition), #condition, __FILE__, __LINE__)
+
+bool check(bool ok, const char* expression, const char* file, int line) {
+    if (!ok) {
+        ++failures;
+        std::cout << file << ':' << line << ": check failed: " << expression << '\n';
+    }
+    return ok;
+}
+
+// name of the i-th numbered stop ("S0", "S1", ...)
+std::string getStopName(size_t i) {
+    return std::string{"S"}.append(std::to_string(i));
+}
+
+// temporary directory of a test, removed with the files in it at the end of the test
+class TestDirectory {
+public:
+    explicit TestDirectory(const std::string& name)
+        : path_(std::filesystem::temp_directory_path() /
+                ("raptor_tests_" + name + '_' + std::to_string(std::random_device{}()))) {
+        std::filesystem::create_directories(path_);
+    }
+
+    ~TestDirectory() {
+        std::error_code error;
+        std::filesystem::remove_all(path_, error);
+    }
+
+    TestDirectory(const TestDirectory&) = delete;
+    TestDirectory& operator=(const TestDirectory&) = delete;
+
+    [[nodiscard]]
+    const std::filesystem::path& getPath() const { return path_; }
+
+    // write the file in the directory
+    void write(const std::string& filename, std::string_view content) const {
+        std::ofstream{path_ / filename} << content;
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+// small hand-made timetable written as csv files into a temporary directory
+class TestTimetable {
+public:
+    explicit TestTimetable(const std::string& name) : directory_(name) {}
+
+    // add stop, returns its id
+    size_t addStop(const std::string& name) {
+        stops_.emplace_back(name);
+        coordinates_.emplace_back(std::nullopt);
+        return stops_.size() - 1;
+    }
+
+    // add stop with coordinates, returns its id
+    size_t addStop(const std::string& name, Coordinates coordinates) {
+        auto&& id = addStop(name);
+        coordinates_.back() = coordinates;
+        return id;
+    }
+
+    // add route serving stops, returns its id
+    size_t addRoute(const std::vector<size_t>& stops) {
+        routes_.emplace_back(stops);
+        return routes_.size() - 1;
+    }
+
+    // add trip of route with (arrival, departure) at every stop of the route,
+    // trips of a route have to be added in the order of their departures
+    void addTrip(size_t route, const std::vector<std::pair<size_t, size_t>>& times) {
+        trips_.emplace_back(route, times);
+    }
+
+    // write the csv files and read them into a new timetable
+    Timetable& load(bool compressStopTimes, bool renumber=false) {
+        write();
+        timetable_ = std::make_unique<Timetable>();
+        CHECK(timetable_->readCSVData(compressStopTimes, directory_.getPath().string()));
+        if (renumber) timetable_->renumber();
+        timetable_->createTransfers();
+        timetable_->computeTripTransfers(1);
+        timetable_->createConnections();
+        timetable_->createDepartures();
+        timetable_->createStopGrid();
+        return *timetable_;
+    }
+
+private:
+    void write() const {
+        // coordinates are written only if some stop has them
+        bool withCoordinates = std::ranges::any_of(coordinates_, [](auto&& c) { return c.has_value(); });
+        std::ofstream stops{directory_.getPath() / "stops.csv"};
+        stops << "stop_index,stop_name" << (withCoordinates ? ",stop_lat,stop_lon\n" : "\n");
+        stops << std::setprecision(10);
+        for (size_t id = 0; id < stops_.size(); ++id) {
+            stops << id << ',' << stops_[id];
+            if (coordinates_[id]) stops << ',' << coordinates_[id]->latitude << ',' << coordinates_[id]->longitude;
+            else if (withCoordinates) stops << ",,";
+            stops << '\n';
+        }
+
+        std::ofstream routes{directory_.getPath() / "routes.csv"};
+        routes << "route_index,route_short_name,route_type\n";
+        for (size_t id = 0; id < routes_.size(); ++id) routes << id << ",R" << id << ",3\n";
+
+        std::ofstream trips{directory_.getPath() / "trips.csv"};
+        std::ofstream stopTimes{directory_.getPath() / "stop_times.csv"};
+        trips << "trip_index,route_index,trip_headsign,direction_id\n";
+        stopTimes << "trip_index,arrival_time,departure_time,stop_index\n";
+        for (size_t id = 0; id < trips_.size(); ++id) {
+            auto&& [route, times] = trips_[id];
+            trips << id << ',' << route << ",T" << id << ",0\n";
+            for (size_t i = 0; i < times.size(); ++i) {
+                stopTimes << id << ',' << times[i].first << ',' << times[i].second << ',' << routes_[route][i] << '\n';
+            }
+        }
+    }
+
+    TestDirectory directory_;
+    std::vector<std::string> stops_;
+    std::vector<std::optional<Coordinates>> coordinates_;
+    std::vector<std::vector<size_t>> routes_;
+    std::vector<std::pair<size_t, std::vector<std::pair<size_t, size_t>>>> trips_;
+    std::unique_ptr<Timetable> timetable_;
+};
+
+// check that journey is a valid connection of the query with the expected result
+bool checkJourney(std::string_view engine, Timetable& timetable, const Journey& journey,
+                  const ReferenceSearch::Result& expected, const Query& query) {
+    size_t failed = failures;
+    CHECK(journey.getArrivalTime() == expected.arrivalTime);
+
+    if (journey.found()) {
+        CHECK(!journey.empty() && journey.size() <= query.maxTrips);
+        CHECK(journey.size() == expected.trips);
+
+        for (size_t l = 0; l < journey.size(); ++l) {
+            auto&& leg = journey[l];
+            auto&& stops = leg.trip->getRoute()->getStops();
+            CHECK(leg.fromIndex < leg.toIndex && leg.toIndex < stops.size());
+            CHECK(stops[leg.fromIndex] == leg.from && stops[leg.toIndex] == leg.to);
+
+            if (l == 0) {
+                auto&& access = std::ranges::find(query.access, leg.from, &StopOffset::stop);
+                CHECK(access != query.access.end() && leg.getDepartureTime() >= query.startTime + access->offset);
+                continue;
+            }
+
+            // change at the same stop or walk to a stop with the same name
+            auto&& previous = journey[l - 1];
+            size_t changeTime = ReferenceSearch::CHANGE_TIME;
+            if (previous.to != leg.from) {
+                CHECK(timetable.getName(*previous.to) == timetable.getName(*leg.from));
+                changeTime += ReferenceSearch::TRANSFER_TIME;
+            }
+            CHECK(leg.getDepartureTime() >= previous.getArrivalTime() + changeTime);
+        }
+
+        // the target is reached from the last stop or after walking to an egress stop
+        auto&& last = journey[journey.size() - 1];
+        size_t arrivalTime = SIZE_MAX;
+        for (auto&& [stop, offset]: query.egress) {
+            if (stop == last.to) {
+                arrivalTime = std::min(arrivalTime, last.getArrivalTime() + offset);
+            }
+            else if (timetable.getName(*stop) == timetable.getName(*last.to)) {
+                arrivalTime = std::min(arrivalTime, last.getArrivalTime() + ReferenceSearch::TRANSFER_TIME + offset);
+            }
+        }
+        CHECK(journey.getArrivalTime() == arrivalTime);
+    }
+
+    // every journey has to fit into the output buffer of the engines
+    std::array<char, 4096> buffer; // NOLINT(cppcoreguidelines-pro-type-member-init)
+    CHECK(JourneyFormatter::writeText(journey, timetable.getStrings(), buffer, true).has_value());
+    CHECK(JourneyFormatter::writeJson(journey, timetable.getStrings(), buffer).has_value());
+
+    if (failed != failures) {
+        auto printStops = [&](const std::vector<StopOffset>& stops) {
+            for (auto&& [stop, offset]: stops) std::cout << ' ' << timetable.getName(*stop) << '+' << offset;
+        };
+        std::cout << "    " << engine << ":";
+        printStops(query.access);
+        std::cout << " ->";
+        printStops(query.egress);
+        std::cout << " at " << query.startTime << ", expected " << expected.arrivalTime << " with "
+                  << expected.trips << " trips, got " << journey.getArrivalTime() << " with "
+                  << journey.size() << " trips\n";
+        return false;
+    }
+    return true;
+}
+
+// run the query with all engines and compare them with the reference search
+ReferenceSearch::Result checkQuery(Timetable& timetable, const ReferenceSearch& reference, const Query& query) {
+    auto&& expected = reference.search(query);
+
+    for (auto&& type: {EngineType::Raptor, EngineType::TripBased, EngineType::ConnectionScan}) {
+        if (type == EngineType::TripBased && timetable.getTripTransfers()->empty()) continue;
+        if (type == EngineType::ConnectionScan && timetable.getConnections()->empty()) continue;
+
+        auto&& engine = createEngine(type, timetable, query);
+        engine->search();
+        CHECK(engine->getJourney().isComplete());
+        checkJourney(getEngineName(type), timetable, engine->getJourney(), expected, query);
+    }
+
+    // raptor without the parent records
+    Raptor raptor{timetable, query};
+    raptor.raptor(true);
+    CHECK(raptor.getArrivalTime() == expected.arrivalTime);
+    CHECK(raptor.getJourney().getArrivalTime() == expected.arrivalTime && raptor.getJourney().empty());
+    return expected;
+}
+
+// query from all stops named startName to all stops named endName
+ReferenceSearch::Result checkQuery(Timetable& timetable, const ReferenceSearch& reference,
+                                   const std::string& startName, const std::string& endName, size_t startTime,
+                                   size_t maxTrips=Query::DEFAULT_MAX_TRIPS) {
+    auto&& query = timetable.createQuery(startName, endName, startTime);
+    query.maxTrips = maxTrips;
+    return checkQuery(timetable, reference, query);
+}
+
+// changing trips at the same stop takes exactly 30 s
+void testChangeTime(bool compress) {
+    TestTimetable data{"change"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C");
+    auto first = data.addRoute({a, b});
+    auto second = data.addRoute({b, c});
+    data.addTrip(first, {{100, 100}, {200, 200}});
+    data.addTrip(second, {{229, 229}, {300, 300}});
+    data.addTrip(second, {{230, 230}, {310, 310}});
+
+    auto&& timetable = data.load(compress);
+    ReferenceSearch reference{timetable};
+    auto&& result = checkQuery(timetable, reference, "A", "C", 0);
+    CHECK(result.arrivalTime == 310 + ReferenceSearch::TRANSFER_TIME && result.trips == 2);
+}
+
+// walking to a stop with the same name takes 120 s (+ 30 s change)
+void testWalkingTransfer(bool compress) {
+    TestTimetable data{"walk"};
+    auto a = data.addStop("A"), b1 = data.addStop("B"), b2 = data.addStop("B"), c = data.addStop("C");
+    auto first = data.addRoute({a, b1});
+    auto second = data.addRoute({b2, c});
+    data.addTrip(first, {{100, 100}, {200, 200}});
+    data.addTrip(second, {{349, 349}, {400, 400}});
+    data.addTrip(second, {{350, 350}, {410, 410}});
+
+    auto&& timetable = data.load(compress);
+    ReferenceSearch reference{timetable};
+    auto&& result = checkQuery(timetable, reference, "A", "C", 0);
+    CHECK(result.arrivalTime == 410 + ReferenceSearch::TRANSFER_TIME && result.trips == 2);
+
+    // the start is every stop with the start name, no walking needed
+    result = checkQuery(timetable, reference, "B", "C", 340);
+    CHECK(result.arrivalTime == 400 + ReferenceSearch::TRANSFER_TIME && result.trips == 1);
+}
+
+// trips running over midnight have times over 24 h
+void testMidnight(bool compress) {
+    TestTimetable data{"midnight"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C");
+    auto route = data.addRoute({a, b, c});
+    data.addTrip(route, {{86000, 86000}, {86500, 86520}, {DAY_SECONDS + 900, DAY_SECONDS + 900}});
+
+    auto&& timetable = data.load(compress);
+    ReferenceSearch reference{timetable};
+    auto&& result = checkQuery(timetable, reference, "A", "B", 85000);
+    CHECK(result.arrivalTime == 86500 + ReferenceSearch::TRANSFER_TIME && result.trips == 1);
+
+    result = checkQuery(timetable, reference, "B", "C", 86510);
+    CHECK(result.arrivalTime == DAY_SECONDS + 900 + ReferenceSearch::TRANSFER_TIME);
+
+    // the trip already left
+    result = checkQuery(timetable, reference, "A", "C", 86001);
+    CHECK(result.arrivalTime == SIZE_MAX);
+
+    // times after midnight are printed as the next day
+    auto&& query = timetable.createQuery("A", "B", 85000);
+    Raptor raptor{timetable, query};
+    raptor.raptor();
+    std::array<char, 256> buffer; // NOLINT(cppcoreguidelines-pro-type-member-init)
+    auto&& size = JourneyFormatter::writeText(raptor.getJourney(), timetable.getStrings(), buffer, true);
+    CHECK(size && std::string_view(buffer.data(), *size).find("23:53") != std::string_view::npos);
+    CHECK(size && std::string_view(buffer.data(), *size).find(" 0:02") != std::string_view::npos);
+}
+
+// target that can't be reached at all
+void testUnreachable(bool compress) {
+    TestTimetable data{"unreachable"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C"), d = data.addStop("D");
+    data.addTrip(data.addRoute({a, b}), {{100, 100}, {200, 200}});
+    data.addTrip(data.addRoute({c, d}), {{300, 300}, {400, 400}});
+
+    auto&& timetable = data.load(compress);
+    ReferenceSearch reference{timetable};
+    CHECK(checkQuery(timetable, reference, "A", "D", 0).arrivalTime == SIZE_MAX);
+    CHECK(checkQuery(timetable, reference, "B", "A", 0).arrivalTime == SIZE_MAX);
+}
+
+// at most query.maxTrips trips are used
+void testTripLimit(bool compress) {
+    TestTimetable data{"limit"};
+    std::vector<size_t> stops;
+    for (size_t i = 0; i <= Raptor::MAX_TRIPS + 1; ++i) stops.emplace_back(data.addStop(getStopName(i)));
+    for (size_t i = 0; i <= Raptor::MAX_TRIPS; ++i) {
+        auto time = 1000 * (i + 1);
+        data.addTrip(data.addRoute({stops[i], stops[i + 1]}), {{time, time}, {time + 500, time + 500}});
+    }
+
+    auto&& timetable = data.load(compress);
+    ReferenceSearch reference{timetable};
+    for (size_t maxTrips = 1; maxTrips <= Raptor::MAX_TRIPS; ++maxTrips) {
+        auto&& last = getStopName(maxTrips);
+        auto&& result = checkQuery(timetable, reference, "S0", last, 0, maxTrips);
+        CHECK(result.arrivalTime == 1000 * maxTrips + 500 + ReferenceSearch::TRANSFER_TIME && result.trips == maxTrips);
+
+        auto&& unreachable = getStopName(maxTrips + 1);
+        CHECK(checkQuery(timetable, reference, "S0", unreachable, 0, maxTrips).arrivalTime == SIZE_MAX);
+    }
+}
+
+// searches stopped by the limits return a valid (maybe slower) connection or none
+void testLimits(bool compress) {
+    TestTimetable data{"limits"};
+    std::vector<size_t> stops;
+    for (size_t i = 0; i <= 3; ++i) stops.emplace_back(data.addStop(getStopName(i)));
+    for (size_t i = 0; i < 3; ++i) {
+        auto time = 1000 * (i + 1);
+        data.addTrip(data.addRoute({stops[i], stops[i + 1]}), {{time, time}, {time + 500, time + 500}});
+    }
+    // slow direct trip
+    data.addTrip(data.addRoute({stops[0], stops[3]}), {{100, 100}, {9000, 9000}});
+
+    auto&& timetable = data.load(compress);
+    ReferenceSearch reference{timetable};
+    auto&& expected = checkQuery(timetable, reference, "S0", "S3", 0);
+    CHECK(expected.arrivalTime == 3500 + ReferenceSearch::TRANSFER_TIME && expected.trips == 3);
+
+    auto checkLimits = [&](const SearchLimits& limits) {
+        auto&& query = timetable.createQuery("S0", "S3", 0);
+        query.limits = limits;
+        for (auto&& type: {EngineType::Raptor, EngineType::TripBased, EngineType::ConnectionScan}) {
+            auto&& engine = createEngine(type, timetable, query);
+            engine->search();
+            auto&& journey = engine->getJourney();
+            CHECK(engine->isInterrupted() && !journey.isComplete());
+            CHECK(!journey.found() || journey.getArrivalTime() >= expected.arrivalTime);
+            checkJourney(getEngineName(type), timetable, journey, {journey.getArrivalTime(), journey.size()}, query);
+        }
+    };
+
+    // cancelled before the search started
+    std::atomic<bool> cancelled{true};
+    SearchLimits limits;
+    limits.cancelled = &cancelled;
+    checkLimits(limits);
+
+    // deadline in the past
+    limits = {};
+    limits.deadline = std::chrono::steady_clock::now();
+    checkLimits(limits);
+
+    // work budgets too small to finish the search
+    for (size_t maxWork = 0; maxWork < 3; ++maxWork) {
+        limits = {};
+        limits.maxWork = maxWork;
+        checkLimits(limits);
+    }
+
+    // large enough limits don't change anything
+    auto&& query = timetable.createQuery("S0", "S3", 0);
+    cancelled = false;
+    query.limits.cancelled = &cancelled;
+    query.limits.maxWork = 1000;
+    query.limits.deadline = std::chrono::steady_clock::now() + std::chrono::hours{1};
+    checkQuery(timetable, reference, query);
+}
+
+// the same arrival with fewer trips is preferred
+void testFewerTrips(bool compress) {
+    TestTimetable data{"fewer"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C");
+    data.addTrip(data.addRoute({a, b}), {{100, 100}, {200, 200}});
+    data.addTrip(data.addRoute({b, c}), {{300, 300}, {400, 400}});
+    data.addTrip(data.addRoute({a, c}), {{150, 150}, {400, 400}});
+
+    auto&& timetable = data.load(compress);
+    ReferenceSearch reference{timetable};
+    auto&& result = checkQuery(timetable, reference, "A", "C", 0);
+    CHECK(result.arrivalTime == 400 + ReferenceSearch::TRANSFER_TIME && result.trips == 1);
+}
+
+// trips can run between stops in zero time (the connections have the same times)
+void testZeroTravelTime(bool compress) {
+    TestTimetable data{"zero"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C"), d = data.addStop("D");
+    data.addTrip(data.addRoute({a, b, c}), {{100, 100}, {100, 100}, {100, 100}});
+    data.addTrip(data.addRoute({c, d}), {{130, 130}, {200, 200}});
+
+    auto&& timetable = data.load(compress);
+    ReferenceSearch reference{timetable};
+    auto&& result = checkQuery(timetable, reference, "A", "D", 0);
+    CHECK(result.arrivalTime == 200 + ReferenceSearch::TRANSFER_TIME && result.trips == 2);
+}
+
+// source and target given by several stops with different walking times
+void testAccessEgress(bool compress) {
+    TestTimetable data{"access"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C"), d = data.addStop("D");
+    auto e = data.addStop("E");
+    data.addTrip(data.addRoute({a, c}), {{100, 100}, {1000, 1000}});
+    data.addTrip(data.addRoute({b, d}), {{400, 400}, {700, 700}});
+    data.addTrip(data.addRoute({b, e}), {{400, 400}, {650, 650}});
+
+    auto&& timetable = data.load(compress);
+    auto&& transferCount = timetable.getTransfers().size();
+    ReferenceSearch reference{timetable};
+
+    // B is closer to the target, but too far from the source
+    Query query{{{&timetable.getStops().at(a), 0}, {&timetable.getStops().at(b), 401}},
+                {{&timetable.getStops().at(c), 0}, {&timetable.getStops().at(d), 60}}, 0};
+    auto&& result = checkQuery(timetable, reference, query);
+    CHECK(result.arrivalTime == 1000 && result.trips == 1);
+
+    // now B can be reached in time, D is better than C
+    query.access[1].offset = 400;
+    result = checkQuery(timetable, reference, query);
+    CHECK(result.arrivalTime == 760 && result.trips == 1);
+
+    // another egress stop with a long walk doesn't change anything, a short one does
+    query.egress.push_back({&timetable.getStops().at(e), 200});
+    CHECK(checkQuery(timetable, reference, query).arrivalTime == 760);
+    query.egress.back().offset = 100;
+    CHECK(checkQuery(timetable, reference, query).arrivalTime == 750);
+
+    // queries don't change the timetable
+    CHECK(timetable.getTransfers().size() == transferCount && timetable.getStops().size() == 5);
+}
+
+// next departures from a stop and from all stops with the same name
+void testDepartures(bool compress) {
+    TestTimetable data{"departures"};
+    auto a1 = data.addStop("A"), a2 = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C");
+    auto r1 = data.addRoute({a1, b}), r2 = data.addRoute({a2, c}), r3 = data.addRoute({b, a1});
+    data.addTrip(r1, {{100, 100}, {200, 200}});
+    data.addTrip(r1, {{300, 300}, {400, 400}});
+    data.addTrip(r2, {{150, 160}, {250, 250}});
+    data.addTrip(r2, {{300, 300}, {350, 350}});
+    data.addTrip(r3, {{0, 0}, {50, 50}});
+
+    auto&& timetable = data.load(compress);
+    auto&& departures = *timetable.getDepartures();
+    auto&& stopA1 = timetable.getStops().at(a1);
+
+    // no departure from the last stop of a trip
+    CHECK(departures.getDepartures(stopA1).size() == 2);
+    CHECK(departures.getDepartures(timetable.getStops().at(c)).empty());
+
+    auto&& next = departures.getNextDepartures(stopA1, 101, 5);
+    CHECK(next.size() == 1 && next[0].time == 300 && next[0].trip == 1);
+    CHECK(departures.getNextDepartures(stopA1, 0, 1).size() == 1);
+    CHECK(departures.getNextDepartures(stopA1, 301, 5).empty());
+
+    // both stops named A merged by time, ties ordered by trip
+    auto&& board = departures.getNextDepartures(timetable.getStopsByName("A"), 100, 3);
+    CHECK(board.size() == 3);
+    if (board.size() == 3) {
+        CHECK(board[0].time == 100 && board[0].stop == a1);
+        CHECK(board[1].time == 160 && board[1].stop == a2 && board[1].index == 0);
+        CHECK(board[2].time == 300 && board[2].trip == 1);
+    }
+    CHECK(departures.getNextDepartures(timetable.getStopsByName("A"), 0, 10).size() == 4);
+}
+
+// delayed trips overtaking other trips of the route
+void testDelays(bool compress) {
+    TestTimetable data{"delays"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C");
+    auto route = data.addRoute({a, b, c});
+    data.addTrip(route, {{100, 100}, {200, 200}, {300, 300}});
+    data.addTrip(route, {{200, 200}, {300, 300}, {400, 400}});
+
+    auto&& timetable = data.load(compress);
+    auto&& stopA = timetable.getStops().at(a);
+    auto scheduled = timetable.getSchedule();
+    auto scheduledDepartures = timetable.getDepartures();
+
+    // a search created before the delays keeps the times it started with
+    auto&& query = timetable.createQuery("A", "C", 0);
+    Raptor raptor{timetable, query};
+
+    std::vector<TripDelay> delays{{0, 250}, {5, 60}};
+    CHECK(timetable.applyDelays(delays) == 1);
+    CHECK(timetable.applyDelays(delays) == 0);
+    auto schedule = timetable.getSchedule();
+    auto&& routeTrips = schedule->getTrips(timetable.getRoutes().at(route));
+    auto&& trips = routeTrips.getTrips();
+    CHECK(schedule != scheduled && schedule->hasDelays() && routeTrips.getLaneCount() == 1);
+    CHECK(trips[0]->getId() == 1 && trips[1]->getId() == 0);
+    CHECK(routeTrips.getTimes()[1].getDepartureTime(0) == 350 && routeTrips.getTimes()[1].getArrivalTime(2) == 550);
+    CHECK(&schedule->getTimes(*trips[1]) == &routeTrips.getTimes()[1]);
+
+    raptor.search();
+    CHECK(raptor.getArrivalTime() == 300 + ReferenceSearch::TRANSFER_TIME);
+    CHECK(raptor.getJourney().size() == 1 && raptor.getJourney()[0].getDepartureTime() == 100);
+
+    // the previous schedule and the indices created from it don't change
+    CHECK(!scheduled->hasDelays() && scheduled->getTimes(timetable.getTrips().at(0)).getDepartureTime(0) == 100);
+    CHECK(scheduledDepartures->getDepartures(stopA)[0].time == 100);
+
+    // the derived indices are created again in the background
+    timetable.waitForIndices();
+    CHECK(timetable.getDepartures()->getSchedule() == schedule);
+    CHECK(timetable.getTripTransfers()->getSchedule() == schedule);
+    auto&& departures = timetable.getDepartures()->getDepartures(stopA);
+    CHECK(departures.size() == 2 && departures[0].time == 200 && departures[1].time == 350);
+    ReferenceSearch reference{timetable};
+    CHECK(checkQuery(timetable, reference, "A", "C", 0).arrivalTime == 400 + ReferenceSearch::TRANSFER_TIME);
+    CHECK(checkQuery(timetable, reference, "A", "C", 201).arrivalTime == 550 + ReferenceSearch::TRANSFER_TIME);
+
+    // back on schedule, ahead of schedule doesn't go below midnight
+    delays = {{0, 0}, {1, -300}};
+    CHECK(timetable.applyDelays(delays) == 2);
+    schedule = timetable.getSchedule();
+    auto&& times = schedule->getTrips(timetable.getRoutes().at(route)).getTimes();
+    CHECK(times[0].getDepartureTime(0) == 0 && times[1].getDepartureTime(0) == 100);
+    timetable.waitForIndices();
+}
+
+// delayed trips running faster than the next one overtake it at some stops only,
+// they go to another lane of the route, so that the trips of every lane are sorted at all stops
+void testOvertakingDelay(bool compress) {
+    TestTimetable data{"overtaking"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C");
+    auto route = data.addRoute({a, b, c});
+    data.addTrip(route, {{100, 100}, {200, 200}, {300, 300}});
+    data.addTrip(route, {{200, 200}, {300, 300}, {400, 400}});
+    data.addTrip(route, {{300, 300}, {600, 600}, {700, 700}});
+
+    auto&& timetable = data.load(compress);
+    auto&& routeCount = timetable.getRoutes().size();
+    auto&& trip = [&timetable](size_t id) { return &timetable.getTrips().at(id); };
+    auto&& getTrips = [&timetable, route]() {
+        auto&& trips = timetable.getSchedule()->getTrips(timetable.getRoutes().at(route));
+        std::vector<std::vector<Trip*>> lanes;
+        for (size_t lane = 0; lane < trips.getLaneCount(); ++lane) {
+            lanes.emplace_back(trips.getTrips(lane).begin(), trips.getTrips(lane).end());
+        }
+        return lanes;
+    };
+
+    std::vector<TripDelay> delays{{0, 250}};
+    CHECK(timetable.applyDelays(delays) == 1);
+    timetable.waitForIndices();
+    CHECK(timetable.getRoutes().size() == routeCount && timetable.getStops().at(b).getRoutes().size() == 1);
+    CHECK((getTrips() == std::vector<std::vector<Trip*>>{{trip(1), trip(2)}, {trip(0)}}));
+    CHECK(timetable.getSchedule()->getTimes(*trip(0)).getDepartureTime(1) == 450);
+
+    // the delayed trip is the fastest one from B, though the slow trip departs from A earlier
+    ReferenceSearch reference{timetable};
+    auto&& result = checkQuery(timetable, reference, "B", "C", 301);
+    CHECK(result.arrivalTime == 550 + ReferenceSearch::TRANSFER_TIME && result.trips == 1);
+    CHECK(checkQuery(timetable, reference, "A", "C", 201).arrivalTime == 550 + ReferenceSearch::TRANSFER_TIME);
+
+    // another overtaking trip goes to the existing lane where it doesn't overtake
+    delays = {{1, 200}};
+    CHECK(timetable.applyDelays(delays) == 1);
+    timetable.waitForIndices();
+    CHECK((getTrips() == std::vector<std::vector<Trip*>>{{trip(2)}, {trip(0), trip(1)}}));
+    reference = ReferenceSearch{timetable};
+    CHECK(checkQuery(timetable, reference, "B", "C", 301).arrivalTime == 550 + ReferenceSearch::TRANSFER_TIME);
+    CHECK(checkQuery(timetable, reference, "B", "C", 451).arrivalTime == 600 + ReferenceSearch::TRANSFER_TIME);
+
+    // back on schedule, the trips are merged back into one lane
+    delays = {{0, 0}, {1, 0}};
+    CHECK(timetable.applyDelays(delays) == 2);
+    timetable.waitForIndices();
+    CHECK((getTrips() == std::vector<std::vector<Trip*>>{{trip(0), trip(1), trip(2)}}));
+    CHECK(!timetable.getSchedule()->hasDelays());
+    reference = ReferenceSearch{timetable};
+    CHECK(checkQuery(timetable, reference, "B", "C", 150).arrivalTime == 300 + ReferenceSearch::TRANSFER_TIME);
+}
+
+// searches running while the delays change see either the previous or the new schedule
+void testConcurrentDelays(bool compress) {
+    TestTimetable data{"concurrent"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C");
+    auto route = data.addRoute({a, b, c});
+    data.addTrip(route, {{100, 100}, {200, 200}, {300, 300}});
+    data.addTrip(route, {{300, 300}, {600, 600}, {700, 700}});
+
+    auto&& timetable = data.load(compress);
+    auto&& query = timetable.createQuery("B", "C", 301);
+    std::atomic<bool> done{false};
+    std::atomic<size_t> wrong{0};
+    std::thread searches{[&]() {
+        while (!done.load()) {
+            for (auto&& type: {EngineType::Raptor, EngineType::TripBased, EngineType::ConnectionScan}) {
+                auto&& engine = createEngine(type, timetable, query);
+                engine->search();
+                auto&& journey = engine->getJourney();
+
+                // the delayed trip arrives at 550, the next one at 700
+                auto&& arrival = journey.getArrivalTime() - ReferenceSearch::TRANSFER_TIME;
+                if (journey.size() != 1 || (arrival != 550 && arrival != 700) ||
+                    journey[0].getArrivalTime() != arrival) {
+                    ++wrong;
+                }
+            }
+        }
+    }};
+    for (size_t i = 0; i < 200; ++i) {
+        std::vector<TripDelay> delays{{0, i % 2 == 0 ? 250 : 0}};
+        timetable.applyDelays(delays);
+        if (i % 50 == 0) timetable.waitForIndices();
+    }
+    done.store(true);
+    searches.join();
+    CHECK(wrong.load() == 0);
+    timetable.waitForIndices();
+    CHECK(!timetable.getSchedule()->hasDelays());
+    CHECK(timetable.getConnections()->getSchedule() == timetable.getSchedule());
+}
+
+// malformed rows of the delay feed are skipped and counted, the rest of the feed is read
+void testDelayFeed() {
+    TestDirectory directory{"feed"};
+    directory.write("delays.csv", "trip_index,delay\r\n0,120\r\n1,-60\r\nx,60\r\n2,\r\n3\r\n\r\n"
+                                  "4,99999999999\r\n5,30\r\n");
+    DelayFeed feed;
+    CHECK(feed.read((directory.getPath() / "delays.csv").string()));
+    auto&& delays = feed.getDelays();
+    CHECK(delays.size() == 3 && feed.getSkippedRowCount() == 4);
+    if (delays.size() == 3) {
+        CHECK(delays[0].trip == 0 && delays[0].delay == 120 && delays[1].trip == 1 && delays[1].delay == -60);
+        CHECK(delays[2].trip == 5 && delays[2].delay == 30);
+    }
+    CHECK(!feed.read((directory.getPath() / "missing.csv").string()));
+}
+
+// stops around coordinates as the source and the target
+void testCoordinates(bool compress) {
+    TestTimetable data{"coordinates"};
+
+    // 0.0009 degrees of latitude is about 100 m
+    auto a = data.addStop("A", {50.0, 14.0}), b = data.addStop("B", {50.0009, 14.0});
+    auto c = data.addStop("C", {50.1, 14.0}), d = data.addStop("D", {50.1009, 14.0});
+    auto e = data.addStop("E");
+    data.addTrip(data.addRoute({a, c}), {{1000, 1000}, {2000, 2000}});
+    data.addTrip(data.addRoute({b, d}), {{1000, 1000}, {1900, 1900}});
+
+    auto&& timetable = data.load(compress);
+    CHECK(!timetable.getCoordinates(timetable.getStops().at(e)));
+
+    auto&& around = timetable.getStopsAround({50.0, 14.0});
+    CHECK(around.size() == 2);
+    if (around.size() == 2) {
+        CHECK(around[0].stop->getId() == a && around[0].offset == 0);
+        CHECK(around[1].stop->getId() == b && around[1].offset == 84);
+    }
+    CHECK(timetable.getStopsAround({50.0, 14.0}, 1).size() == 1);
+    CHECK(timetable.getStopsAround({50.0, 14.0}, 5, 50).size() == 1);
+    CHECK(timetable.getStopsAround({50.05, 14.0}).empty());
+
+    // walking to B and from D is faster
+    ReferenceSearch reference{timetable};
+    auto&& result = checkQuery(timetable, reference, "50.0,14.0", "50.1, 14.0", 0);
+    CHECK(result.arrivalTime == 1984 && result.trips == 1);
+    result = checkQuery(timetable, reference, "50.0,14.0", "C", 0);
+    CHECK(result.arrivalTime == 2000 + ReferenceSearch::TRANSFER_TIME && result.trips == 1);
+    CHECK(!Coordinates::parse("A") && !Coordinates::parse("50.0,") && !Coordinates::parse("91,14"));
+}
+
+// nearest stops from the grid compared with all stops
+void testStopGrid() {
+    TestTimetable data{"grid"};
+    std::mt19937 random{RANDOM_SEED};
+    std::uniform_real_distribution<double> latitude{49.9, 50.2};
+    std::uniform_real_distribution<double> longitude{14.2, 14.7};
+    for (size_t i = 0; i < 2000; ++i) data.addStop(getStopName(i), {latitude(random), longitude(random)});
+
+    auto&& timetable = data.load(false);
+    auto&& grid = timetable.getStopGrid();
+
+    // the same distances as in the grid
+    auto getDistance = [](Coordinates p1, Coordinates p2, double scale) {
+        constexpr double toMeters = std::numbers::pi / 180 * 6371000;
+        return std::hypot((p1.longitude - p2.longitude) * scale * toMeters, (p1.latitude - p2.latitude) * toMeters);
+    };
+    double latitudeSum = 0;
+    for (auto&& [_, stop]: timetable.getStops()) latitudeSum += timetable.getCoordinates(stop)->latitude;
+    auto&& scale = std::cos(latitudeSum / 2000 * std::numbers::pi / 180);
+
+    for (size_t i = 0; i < 500; ++i) {
+        Coordinates point{latitude(random), longitude(random)};
+        size_t count = 1 + i % 10;
+        double radius = 100.0 * static_cast<double>(1 + i % 20);
+
+        std::vector<double> expected;
+        for (auto&& [_, stop]: timetable.getStops()) {
+            auto&& distance = getDistance(point, *timetable.getCoordinates(stop), scale);
+            if (distance <= radius) expected.emplace_back(distance);
+        }
+        std::ranges::sort(expected);
+        expected.resize(std::min(expected.size(), count));
+
+        auto&& nearest = grid.findNearest(point, count, radius);
+        if (!CHECK(nearest.size() == expected.size())) continue;
+        for (size_t j = 0; j < nearest.size(); ++j) {
+            CHECK(std::abs(nearest[j].distance - expected[j]) < 1e-6);
+            CHECK(std::abs(getDistance(point, *timetable.getCoordinates(*nearest[j].stop), scale) - expected[j]) < 1e-6);
+        }
+    }
+}
+
+// renumbered stops of a route get consecutive ids, the original ids are kept
+void testRenumber(bool compress) {
+    TestTimetable data{"renumber"};
+    auto c = data.addStop("C"), x = data.addStop("X"), a = data.addStop("A"), b1 = data.addStop("B");
+    auto d = data.addStop("D"), b2 = data.addStop("B");
+    auto first = data.addRoute({a, b1}), second = data.addRoute({b2, c, d});
+    data.addTrip(first, {{100, 100}, {200, 200}});
+    data.addTrip(second, {{400, 400}, {500, 500}, {600, 600}});
+
+    auto&& timetable = data.load(compress, true);
+    auto&& stops = timetable.getStops();
+    CHECK(timetable.getStopCount() == 6 && stops.size() == 6);
+    for (auto&& id: {c, x, a, b1, d, b2}) CHECK(stops.at(id).getOriginalId() == id);
+
+    // C is reached first, then the stops of the second route (both stops named B together)
+    CHECK(stops.at(c).getId() == 0 && stops.at(b1).getId() == 1 && stops.at(b2).getId() == 2);
+    CHECK(stops.at(d).getId() == 3 && stops.at(a).getId() == 4 && stops.at(x).getId() == 5);
+    CHECK(timetable.getRoutes().at(second).getId() == 0 && timetable.getRoutes().at(first).getId() == 1);
+    CHECK(timetable.getRoutes().at(first).getStops()[0] == &stops.at(a));
+
+    ReferenceSearch reference{timetable};
+    auto&& result = checkQuery(timetable, reference, "A", "D", 0);
+    CHECK(result.arrivalTime == 600 + ReferenceSearch::TRANSFER_TIME && result.trips == 2);
+
+    // the original ids are in the output
+    auto&& query = timetable.createQuery("A", "D", 0);
+    Raptor raptor{timetable, query};
+    raptor.search();
+    std::array<char, 1024> buffer{};
+    auto&& length = JourneyFormatter::writeJson(raptor.getJourney(), timetable.getStrings(), buffer);
+    std::string_view json(buffer.data(), length.value_or(0));
+    CHECK(json.find("{\"id\":5,\"name\":\"B\"}") != std::string_view::npos);
+}
+
+// the arrays of routes and stops moved into the arena keep the stop times (and delays) of the trips
+void testCompact(bool compress) {
+    TestTimetable data{"compact"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C"), d = data.addStop("D");
+    auto first = data.addRoute({a, b, c}), second = data.addRoute({c, d});
+    data.addTrip(first, {{100, 100}, {200, 210}, {300, 300}});
+    data.addTrip(first, {{400, 400}, {500, 510}, {600, 600}});
+    data.addTrip(second, {{330, 330}, {400, 400}});
+    data.addTrip(second, {{700, 700}, {800, 800}});
+
+    auto&& timetable = data.load(compress);
+    std::vector<TripDelay> delays{{1, 60}};
+    CHECK(timetable.applyDelays(delays) == 1);
+    for (auto&& hugePages: {HugePages::None, HugePages::Transparent, HugePages::Explicit}) {
+        CHECK(timetable.compact(hugePages));
+        auto&& schedule = timetable.getSchedule();
+        auto&& arena = timetable.getArena();
+        if (!CHECK(arena != nullptr)) return;
+        CHECK(arena->getUsed() != 0 && arena->getUsed() <= arena->getSize());
+        CHECK(hugePages == HugePages::Explicit || arena->getHugePages() <= hugePages);
+
+        auto&& route = timetable.getRoutes().at(first);
+        CHECK(route.getStopTimes().get_allocator().resource() == arena);
+        CHECK(timetable.getStops().at(c).getRoutes().get_allocator().resource() == arena);
+        auto&& trips = route.getTrips();
+        CHECK(trips[0]->getArrivalTime(1) == 200 && trips[0]->getDepartureTime(1) == 210);
+        CHECK(trips[1]->getDepartureTime(0) == 400 && trips[1]->getArrivalTime(2) == 600);
+        auto&& times = schedule->getTimes(*trips[1]);
+        CHECK(times.getDepartureTime(0) == 460 && times.getArrivalTime(2) == 660);
+        CHECK(times.arrivalOffsets == trips[1]->getArrivalOffsets());
+
+        // the scheduled times of the trips are in the arena next to each other, in the order of the trips
+        CHECK(route.getTripTimes().get_allocator().resource() == arena);
+        for (auto&& [_, r]: timetable.getRoutes()) {
+            for (size_t t = 0; t < r.getTrips().size(); ++t) {
+                CHECK(r.getTrips()[t]->getTimes() == &r.getTripTimes()[t]);
+            }
+        }
+
+        // the indices are created again from the arrays in the arena
+        CHECK(timetable.getTripTransfers()->getSchedule() == schedule);
+        CHECK(timetable.getConnections()->getSchedule() == schedule);
+
+        ReferenceSearch reference{timetable};
+        CHECK(checkQuery(timetable, reference, "A", "D", 0).arrivalTime == 400 + ReferenceSearch::TRANSFER_TIME);
+        CHECK(checkQuery(timetable, reference, "A", "D", 101).arrivalTime == 800 + ReferenceSearch::TRANSFER_TIME);
+    }
+
+    // back on schedule, the schedule uses the times in the arena again
+    delays = {{1, 0}};
+    CHECK(timetable.applyDelays(delays) == 1);
+    timetable.waitForIndices();
+    auto&& route = timetable.getRoutes().at(first);
+    auto&& times = timetable.getSchedule()->getTrips(route).getTimes();
+    CHECK(times.data() == route.getTripTimes().data() && times[1].getDepartureTime(0) == 400);
+}
+
+// GTFS feed converted into the csv files - filtered routes, trips split by stop pattern and by overtaking
+void testGtfsConverter() {
+    TestDirectory gtfs{"gtfs"};
+    gtfs.write("stops.txt", "\xEF\xBB\xBFstop_id,stop_name,stop_lat,stop_lon\r\n"
+                       "U1Z1,\"Nádraží Holešovice, Vltavská\",50.1,14.4\r\n"
+                       "U2Z1,Želivského,50.2,14.5\r\n"
+                       "U3Z1,\"Na \"\"Vinici\"\"\",50.3,14.6\r\n"
+                       "U4Z1,Unused,50.4,14.7\r\n");
+    gtfs.write("routes.txt", "route_id,route_short_name,route_long_name,route_type,is_regional\n"
+                        "L1,136,,3,0\nL2,S1,,2,0\nL3,301,,3,1\n");
+    gtfs.write("trips.txt", "route_id,service_id,trip_id,trip_headsign,direction_id\n"
+                       "L1,W,T1,Želivského,0\nL1,W,T2,Želivského,0\nL1,W,T3,Želivského,0\nL1,W,T4,Na Vinici,1\n"
+                       "L1,X,T5,Želivského,0\nL2,W,T6,Želivského,0\nL3,W,T7,Želivského,0\n");
+    gtfs.write("calendar.txt", "service_id,monday,tuesday,wednesday,thursday,friday,saturday,sunday,start_date,end_date\n"
+                          "W,1,1,1,1,1,0,0,20260101,20261231\nX,0,0,0,0,0,1,1,20260101,20261231\n");
+    gtfs.write("calendar_dates.txt", "service_id,date,exception_type\nX,20261019,2\n");
+
+    // T2 overtakes T1, T3 runs after midnight, T4 has another pattern, the stop times of T1 aren't sorted
+    gtfs.write("stop_times.txt", "trip_id,arrival_time,departure_time,stop_id,stop_sequence\n"
+                            "T1,0:20:00,0:20:00,U2Z1,2\nT1,0:10:00,0:10:00,U1Z1,1\nT1,0:40:00,0:40:00,U3Z1,3\n"
+                            "T6,0:00:00,0:00:00,U1Z1,1\nT6,0:05:00,0:05:00,U3Z1,2\n"
+                            "T2,0:15:00,0:15:00,U1Z1,1\nT2,0:22:00,0:23:00,U2Z1,2\nT2,0:30:00,0:30:00,U3Z1,3\n"
+                            "T3,25:00:00,25:00:00,U1Z1,1\nT3,25:10:00,25:10:00,U2Z1,2\nT3,25:30:00,25:30:00,U3Z1,3\n"
+                            "T4,0:00:00,0:00:00,U1Z1,1\nT4,0:50:00,0:50:00,U3Z1,2\n"
+                            "T5,0:00:00,0:00:00,U1Z1,1\nT5,0:01:00,0:01:00,U3Z1,2\n");
+
+    GtfsConverter::Options options;
+    options.date = 20261019;
+    GtfsConverter converter{options};
+    CHECK(converter.convert(gtfs.getPath().string(), (gtfs.getPath() / "data").string()));
+    CHECK(converter.getStopCount() == 3 && converter.getRouteCount() == 3 && converter.getTripCount() == 4);
+    CHECK(converter.getStopTimeCount() == 11 && converter.getSkippedTripCount() == 1);
+
+    Timetable timetable;
+    CHECK(timetable.readCSVData(false, (gtfs.getPath() / "data").string()));
+    CHECK(timetable.getStops().size() == 3 && timetable.getRoutes().size() == 3 && timetable.getTrips().size() == 4);
+    CHECK(timetable.getStopsByName("Nadrazi Holesovice Vltavska").size() == 1);
+    CHECK(timetable.getStopsByName("Na \"Vinici\"").size() == 1);
+    CHECK(timetable.getCoordinates(*timetable.getStopsByName("Zelivskeho")[0]).has_value());
+
+    // the trips of every route are in the same order at all stops
+    for (auto&& [_, route]: timetable.getRoutes()) {
+        auto&& trips = route.getTrips();
+        for (size_t t = 1; t < trips.size(); ++t) {
+            for (size_t i = 0; i < route.getStops().size(); ++i) {
+                CHECK(trips[t - 1]->getArrivalTime(i) <= trips[t]->getArrivalTime(i));
+                CHECK(trips[t - 1]->getDepartureTime(i) <= trips[t]->getDepartureTime(i));
+            }
+        }
+    }
+
+    timetable.createTransfers();
+    timetable.computeTripTransfers(1);
+    timetable.createConnections();
+    ReferenceSearch reference{timetable};
+    auto&& result = checkQuery(timetable, reference, "Nadrazi Holesovice Vltavska", "Na \"Vinici\"", 0);
+    CHECK(result.arrivalTime == 1800 + ReferenceSearch::TRANSFER_TIME && result.trips == 1);
+    result = checkQuery(timetable, reference, "Nadrazi Holesovice Vltavska", "Zelivskeho", 3600);
+    CHECK(result.arrivalTime == 25 * 3600 + 600 + ReferenceSearch::TRANSFER_TIME && result.trips == 1);
+}
+
+// stop times without the times are interpolated between the timed stops after the trip is sorted
+void testGtfsUntimedStops() {
+    TestDirectory gtfs{"gtfs"};
+    gtfs.write("stops.txt", "stop_id,stop_name\nA,A\nB,B\nC,C\nD,D\n");
+    gtfs.write("routes.txt", "route_id,route_short_name,route_type\nL1,1,3\n");
+    gtfs.write("trips.txt", "route_id,service_id,trip_id\nL1,W,T1\nL1,W,T2\n");
+    gtfs.write("calendar.txt", "service_id,monday,tuesday,wednesday,thursday,friday,saturday,sunday,start_date,end_date\n"
+                          "W,1,1,1,1,1,1,1,20260101,20261231\n");
+
+    // the stop times of T1 aren't sorted, B is before A in the file, so the previous row is the last stop D;
+    // the first stop of T2 has no times, so it's skipped
+    gtfs.write("stop_times.txt", "trip_id,arrival_time,departure_time,stop_id,stop_sequence\n"
+                            "T1,0:40:00,0:40:00,D,4\nT1,,,B,2\nT1,0:10:00,0:10:00,A,1\nT1,,,C,3\n"
+                            "T2,0:20:00,0:20:00,B,2\nT2,,,A,1\n");
+
+    GtfsConverter::Options options;
+    options.date = 20261019;
+    GtfsConverter converter{options};
+    CHECK(converter.convert(gtfs.getPath().string(), (gtfs.getPath() / "data").string()));
+    CHECK(converter.getTripCount() == 1 && converter.getStopTimeCount() == 4 && converter.getSkippedTripCount() == 1);
+
+    Timetable timetable;
+    CHECK(timetable.readCSVData(false, (gtfs.getPath() / "data").string()));
+    CHECK(timetable.getTrips().size() == 1);
+    for (auto&& [_, trip]: timetable.getTrips()) {
+        for (size_t i = 0; i < 4; ++i) {
+            CHECK(trip.getArrivalTime(i) == 600 + 600 * i && trip.getDepartureTime(i) == 600 + 600 * i);
+        }
+    }
+}
+
+// query log records are read back as they were written, a truncated last record and damaged records are skipped
+void testQueryLog() {
+    auto&& filename = (std::filesystem::temp_directory_path() /
+        ("raptor_tests_log_" + std::to_string(std::random_device{}()) + ".qlog")).string();
+
+    std::vector<QueryRecord> records(3);
+    records[0] = {"Malostranske namesti", "Bazar", 28800, EngineType::Raptor, 5};
+    records[0].setResult({}, std::chrono::microseconds{1500});
+    records[1] = {"50.0875,14.4214", "Nádraží Holešovice", 90000, EngineType::TripBased, 3, 100, 50};
+    records[2] = {"", "B", 0, EngineType::ConnectionScan, 8};
+    records[2].arrivalTime = 1000;
+    records[2].trips = 2;
+    records[2].complete = false;
+
+    // two processes appending to the same log
+    for (size_t i = 0; i < records.size(); ++i) {
+        QueryLog log;
+        CHECK(log.open(filename) && log.write(records[i]));
+    }
+    std::vector<QueryRecord> read;
+    CHECK(QueryLog::read(filename, read) && read.size() == records.size());
+    for (size_t i = 0; i < std::min(read.size(), records.size()); ++i) {
+        auto&& [a, b] = std::tie(read[i], records[i]);
+        CHECK(a.startName == b.startName && a.endName == b.endName && a.startTime == b.startTime);
+        CHECK(a.engine == b.engine && a.maxTrips == b.maxTrips && a.maxWork == b.maxWork && a.timeout == b.timeout);
+        CHECK(a.arrivalTime == b.arrivalTime && a.trips == b.trips && a.complete == b.complete);
+        CHECK(a.duration == b.duration);
+    }
+    CHECK(read[0].duration == 1500000 && read[0].arrivalTime == UINT32_MAX);
+
+    std::filesystem::resize_file(filename, std::filesystem::file_size(filename) - 1);
+    read.clear();
+    CHECK(QueryLog::read(filename, read) && read.size() == records.size() - 1);
+
+    CHECK(QueryLog::save(filename, {records[0]}));
+    auto&& second = std::filesystem::file_size(filename);
+    CHECK(QueryLog::save(filename, records));
+    read.clear();
+    CHECK(QueryLog::read(filename, read) && read.size() == records.size());
+
+    // a damaged record in the middle is skipped, the following one is still read,
+    // first with damaged data (the checksum doesn't match), then with a damaged size
+    for (auto&& position: {second + 12, second}) {
+        CHECK(QueryLog::save(filename, records));
+        std::fstream file{filename, std::ios::binary | std::ios::in | std::ios::out};
+        file.seekp(static_cast<std::streamoff>(position));
+        file.put('\x7f');
+        file.close();
+        read.clear();
+        CHECK(QueryLog::read(filename, read) && read.size() == records.size() - 1);
+        CHECK(read.size() == 2 && read[0].startName == records[0].startName && read[1].endName == records[2].endName);
+    }
+
+    // not a query log, nothing is appended to it
+    std::ofstream{filename} << "trip_index,delay\n";
+    read.clear();
+    CHECK(!QueryLog::read(filename, read) && read.empty());
+    QueryLog log;
+    CHECK(!log.open(filename));
+    std::filesystem::remove(filename);
+}
+
+// travel time matrix computed in shards, the finished shards are kept when it's opened again
+void testTravelTimeMatrix() {
+    TestTimetable data{"matrix"};
+    auto a = data.addStop("A"), b = data.addStop("B"), c = data.addStop("C"), d = data.addStop("D");
+    auto e = data.addStop("E");
+    auto first = data.addRoute({a, b, c}), second = data.addRoute({c, d});
+    data.addTrip(first, {{100, 100}, {200, 200}, {300, 300}});
+    data.addTrip(first, {{1000, 1000}, {1100, 1100}, {1200, 1200}});
+    data.addTrip(second, {{400, 400}, {500, 500}});
+    auto&& timetable = data.load(false);
+
+    auto&& filename = (std::filesystem::temp_directory_path() /
+        ("raptor_tests_matrix_" + std::to_string(std::random_device{}()) + ".bin")).string();
+    TravelTimeMatrix::Options options;
+    options.departureTimes = {0, 150};
+    options.tileSize = 2;
+    options.shardSize = 3;
+    {
+        TravelTimeMatrix matrix;
+        CHECK(matrix.open(filename, timetable, options));
+        CHECK(matrix.getStopCount() == 5 && matrix.getOptions().shardSize == 4 && matrix.getShardCount() == 2);
+        CHECK(matrix.readCheckpoint() == std::vector<bool>(2, false));
+        CHECK(matrix.writeShard(1, matrix.computeShard(timetable, 1)));
+    }
+
+    // the job continues with the unfinished shard, other options don't match the matrix
+    TravelTimeMatrix matrix;
+    CHECK(matrix.open(filename, timetable, options));
+    CHECK(matrix.readCheckpoint() == std::vector<bool>({false, true}));
+    CHECK(matrix.writeShard(0, matrix.computeShard(timetable, 0)));
+    auto other = options;
+    other.departureTimes = {0};
+    TravelTimeMatrix otherMatrix;
+    CHECK(!otherMatrix.open(filename, timetable, other));
+
+    TravelTimeMatrix result;
+    CHECK(result.open(filename) && result.getOptions().departureTimes == options.departureTimes);
+    CHECK(result.readCheckpoint() == std::vector<bool>(2, true));
+    auto unreachable = TravelTimeMatrix::UNREACHABLE;
+    CHECK(result.getTravelTime(0, a, a) == 0 && result.getTravelTime(0, a, b) == 4);
+    CHECK(result.getTravelTime(0, a, c) == 5 && result.getTravelTime(0, a, d) == 9);
+    CHECK(result.getTravelTime(0, a, e) == unreachable && result.getTravelTime(0, b, a) == unreachable);
+    CHECK(result.getTravelTime(0, c, d) == 9 && result.getTravelTime(0, e, e) == 0);
+    CHECK(result.getTravelTime(1, a, b) == 16 && result.getTravelTime(1, a, d) == unreachable);
+    CHECK(result.getTravelTime(1, c, d) == 6 && result.getTravelTime(2, a, b) == unreachable);
+
+    std::filesystem::remove(filename);
+    std::filesystem::remove(filename + ".done");
+}
+
+// departure boards of all stops on the real data, compared with the stop times of the trips
+void checkDepartures(Timetable& timetable) {
+    timetable.createDepartures();
+    auto&& departures = *timetable.getDepartures();
+    auto&& schedule = departures.getSchedule();
+    size_t count = 0;
+    for (auto&& [_, stop]: timetable.getStops()) {
+        auto&& board = departures.getDepartures(stop);
+        count += board.size();
+        CHECK(std::ranges::is_sorted(board, {}, &Departure::time));
+        for (auto&& departure: board) {
+            auto&& trip = departures.getTrip(departure.trip);
+            CHECK(departure.stop == stop.getId());
+            CHECK(trip->getRoute()->getStops()[departure.index] == &stop);
+            CHECK(schedule->getTimes(*trip).getDepartureTime(departure.index) == departure.time);
+        }
+    }
+    size_t expected = 0;
+    for (auto&& [_, trip]: timetable.getTrips()) expected += trip.getRoute()->getStops().size() - 1;
+    CHECK(count == expected);
+}
+
+// random delays on the real data, the lanes of the routes stay sorted and raptor matches the reference search
+void checkDelays(Timetable& timetable, const std::vector<std::string>& names, size_t count) {
+    std::mt19937 random{RANDOM_SEED};
+    std::uniform_int_distribution<int32_t> delay{-120, 900};
+    std::bernoulli_distribution delayed{0.05};
+
+    std::vector<TripDelay> delays;
+    for (auto&& [id, _]: timetable.getTrips()) {
+        if (delayed(random)) delays.push_back({id, delay(random)});
+    }
+    auto&& routeCount = timetable.getRoutes().size();
+    timetable.applyDelays(delays);
+    CHECK(timetable.getRoutes().size() == routeCount);
+
+    // the trips of every lane are sorted at all stops, every lane has some trip
+    auto isSorted = [&timetable]() {
+        auto&& schedule = timetable.getSchedule();
+        return std::ranges::all_of(timetable.getRoutes(), [&schedule](auto&& route) {
+            auto&& routeTrips = schedule->getTrips(route.second);
+            if (routeTrips.getTrips().size() != route.second.getTrips().size()) return false;
+            for (size_t lane = 0; lane < routeTrips.getLaneCount(); ++lane) {
+                auto&& times = routeTrips.getTimes(lane);
+                if (times.empty() && !route.second.getTrips().empty()) return false;
+                for (size_t i = 0; i < route.second.getStops().size(); ++i) {
+                    for (size_t t = 1; t < times.size(); ++t) {
+                        if (times[t].getArrivalTime(i) < times[t - 1].getArrivalTime(i) ||
+                            times[t].getDepartureTime(i) < times[t - 1].getDepartureTime(i)) {
+                            return false;
+                        }
+                    }
+                }
+            }
+            return true;
+        });
+    };
+    CHECK(isSorted());
+
+    // the overtaking trips are in other lanes now, the reference search reads the delayed schedule
+    ReferenceSearch reference{timetable};
+    std::uniform_int_distribution<size_t> name{0, names.size() - 1};
+    std::uniform_int_distribution<size_t> time{0, DAY_SECONDS - 1};
+    for (size_t i = 0; i < count; ++i) {
+        auto&& startName = names[name(random)];
+        auto&& endName = names[name(random)];
+        if (startName == endName) continue;
+        auto&& query = timetable.createQuery(startName, endName, time(random));
+        Raptor raptor{timetable, query};
+        raptor.raptor();
+        checkJourney("raptor", timetable, raptor.getJourney(), reference.search(query), query);
+    }
+
+    // back on schedule, the lanes are merged back
+    for (auto&& d: delays) d.delay = 0;
+    CHECK(timetable.applyDelays(delays) <= delays.size());
+    CHECK(isSorted() && !timetable.getSchedule()->hasDelays());
+    CHECK(std::ranges::all_of(timetable.getTrips(), [](auto&& trip) { return trip.second.getDelay() == 0; }));
+    CHECK(std::ranges::all_of(timetable.getRoutes(), [&timetable](auto&& route) {
+        return timetable.getSchedule()->getTrips(route.second).getLaneCount() == 1;
+    }));
+    timetable.waitForIndices();
+}
+
+// random queries on the data (the generated feed in tests/data under ctest), compared with the reference search
+void testRandomQueries(const std::string& directory, size_t count, bool compress, bool renumber) {
+    if (!std::filesystem::exists(std::filesystem::path{directory} / "stop_times.csv")) {
+        std::cout << "random queries skipped, no data in " << directory << '\n';
+        return;
+    }
+
+    Timetable timetable;
+    if (!CHECK(timetable.readCSVData(compress, directory))) return;
+    if (renumber) timetable.renumber();
+    // the renumbered timetable is also compacted, both layouts are checked
+    if (renumber) CHECK(timetable.compact());
+    auto&& stopCount = timetable.getStops().size();
+    timetable.createTransfers();
+    // saved trip transfers don't match the renumbered stops, computing them takes long, so trip-based is skipped
+    if (!timetable.loadTripTransfers() && !renumber) timetable.computeTripTransfers();
+    timetable.createConnections();
+    ReferenceSearch reference{timetable};
+
+    std::vector<std::string> names;
+    for (auto&& [_, stop]: timetable.getStops()) names.emplace_back(timetable.getName(stop));
+    std::ranges::sort(names);
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    std::mt19937 random{RANDOM_SEED};
+    std::uniform_int_distribution<size_t> name{0, names.size() - 1};
+    std::uniform_int_distribution<size_t> time{0, DAY_SECONDS - 1};
+
+    size_t found = 0;
+    for (size_t i = 0; i < count; ++i) {
+        auto&& startName = names[name(random)];
+        auto&& endName = names[name(random)];
+        if (startName == endName) continue;
+        size_t maxTrips = 1 + i % Raptor::MAX_TRIPS;
+        found += checkQuery(timetable, reference, startName, endName, time(random), maxTrips).arrivalTime != SIZE_MAX;
+    }
+    CHECK(timetable.getStops().size() == stopCount);
+    checkDepartures(timetable);
+    checkDelays(timetable, names, count / 10);
+    std::cout << "random queries" << (renumber ? " (renumbered, compacted): " : ": ") << count
+              << ", connections found: " << found << '\n';
+}
+
+}
+
+// usage: RaptorTests [data directory] [number of random queries]
+int main(int argc, char* argv[]) {
+    std::string directory = argc > 1 ? argv[1] : Timetable::DATA_DIRECTORY;
+    size_t count = argc > 2 ? std::stoul(argv[2]) : RANDOM_QUERY_COUNT;
+
+    for (bool compress: {false, true}) {
+        testChangeTime(compress);
+        testWalkingTransfer(compress);
+        testMidnight(compress);
+        testUnreachable(compress);
+        testTripLimit(compress);
+        testFewerTrips(compress);
+        testZeroTravelTime(compress);
+        testAccessEgress(compress);
+        testLimits(compress);
+        testDepartures(compress);
+        testDelays(compress);
+        testOvertakingDelay(compress);
+        testConcurrentDelays(compress);
+        testCoordinates(compress);
+        testRenumber(compress);
+        testCompact(compress);
+    }
+    testDelayFeed();
+    testStopGrid();
+    testGtfsConverter();
+    testGtfsUntimedStops();
+    testQueryLog();
+    testTravelTimeMatrix();
+    testRandomQueries(directory, count, false, false);
+    testRandomQueries(directory, count / 4, false, true);
+
+    if (failures != 0) {
+        std::cout << failures << " checks failed\n";
+        return 1;
+    }
+    std::cout << "all checks passed\n";
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "ReferenceSearch.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+ReferenceSearch::ReferenceSearch(Timetable& timetable) : schedule_(timetable.getSchedule()) {
+    size_t stopCount = timetable.getStopCount();
+    stops_.resize(stopCount);
+    stopRoutes_.resize(stopCount);
+    footpaths_.resize(stopCount);
+
+    for (auto&& [_, stop]: timetable.getStops()) stops_[stop.getId()] = &stop;
+
+    for (auto&& [_, route]: timetable.getRoutes()) {
+        auto&& stops = route.getStops();
+        for (size_t j = 0; j < stops.size(); ++j) {
+            stopRoutes_[stops[j]->getId()].emplace_back(&route, j);
+        }
+    }
+    for (auto&& [from, toStops]: timetable.getTransfers()) {
+        footpaths_[from->getId()] = toStops;
+    }
+}
+
+ReferenceSearch::Result ReferenceSearch::search(const Query& query) const {
+    auto&& maxTrips = query.maxTrips;
+    auto&& stopCount = stopRoutes_.size();
+    auto node = [stopCount](size_t stopId, size_t trips) { return trips * stopCount + stopId; };
+
+    // node -> the earliest arrival time
+    std::vector<size_t> labels((maxTrips + 1) * stopCount, SIZE_MAX);
+
+    using Entry = std::pair<size_t, size_t>; // time, node
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> queue;
+
+    auto relax = [&](Stop* stop, size_t trips, size_t time) {
+        auto&& n = node(stop->getId(), trips);
+        if (time < labels[n]) {
+            labels[n] = time;
+            queue.emplace(time, n);
+        }
+    };
+
+    for (auto&& [stop, offset]: query.access) relax(stop, 0, query.startTime + offset);
+
+    while (!queue.empty()) {
+        auto [time, n] = queue.top();
+        queue.pop();
+        if (time > labels[n]) continue;
+
+        auto&& trips = n / stopCount;
+        auto&& stop = stops_[n % stopCount];
+
+        // walk (not at the start, the journey starts at the access stops)
+        if (trips > 0) {
+            for (auto&& to: footpaths_[stop->getId()]) relax(to, trips, time + TRANSFER_TIME);
+        }
+
+        if (trips == maxTrips) continue;
+
+        // ride the first trip of every lane of every route that can be boarded (the later ones arrive later)
+        size_t boardingTime = time + (trips > 0 ? CHANGE_TIME : 0);
+        for (auto&& [route, j]: stopRoutes_[stop->getId()]) {
+            auto&& routeStops = route->getStops();
+            auto&& routeTrips = schedule_->getTrips(*route);
+            for (size_t lane = 0; lane < routeTrips.getLaneCount(); ++lane) {
+                for (auto&& times: routeTrips.getTimes(lane)) {
+                    if (times.getDepartureTime(j) < boardingTime) continue;
+                    for (size_t i = j + 1; i < routeStops.size(); ++i) {
+                        relax(routeStops[i], trips + 1, times.getArrivalTime(i));
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    Result result;
+    for (size_t trips = 1; trips <= maxTrips; ++trips) {
+        for (auto&& [stop, offset]: query.egress) {
+            auto&& label = labels[node(stop->getId(), trips)];
+            if (label != SIZE_MAX && label + offset < result.arrivalTime) {
+                result.arrivalTime = label + offset;
+                result.trips = trips;
+            }
+        }
+    }
+    return result;
+}
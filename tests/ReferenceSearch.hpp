@@ -0,0 +1,47 @@
+#ifndef REFERENCESEARCH_HPP_
+#define REFERENCESEARCH_HPP_
+
+#include "Timetable.hpp"
+
+#include <vector>
+
+// simple and slow reference search used to check the real search engines
+// Dijkstra over (stop, number of trips used) nodes (up to query.maxTrips), with the same rules as the raptor algorithm:
+// - trips are boarded at the access stops at the start time + offset
+// - changing trips at the same stop takes CHANGE_TIME, walking to a stop with the same name takes
+//   TRANSFER_TIME (+ CHANGE_TIME before boarding)
+// - the destination is reached offset after arriving at any of the egress stops (using at least one trip)
+// the trips of a lane of a route (see RouteTrips) are expected not to overtake each other
+class ReferenceSearch {
+public:
+    static constexpr size_t CHANGE_TIME = 30;
+    static constexpr size_t TRANSFER_TIME = 120;
+
+    struct Result {
+        // arrival at the destination, SIZE_MAX if it can't be reached
+        size_t arrivalTime = SIZE_MAX;
+
+        // the lowest number of trips needed to arrive at arrivalTime
+        size_t trips = 0;
+    };
+
+    // search the current schedule of timetable
+    explicit ReferenceSearch(Timetable& timetable);
+
+    [[nodiscard]]
+    Result search(const Query& query) const;
+
+private:
+    std::shared_ptr<const Schedule> schedule_;
+
+    // stop id -> stop
+    std::vector<Stop*> stops_;
+
+    // routes of every stop (with the index of the stop along the route), indexed by stop id
+    std::vector<std::vector<std::pair<Route*, size_t>>> stopRoutes_;
+
+    // stops in walking distance from every stop, indexed by stop id
+    std::vector<std::vector<Stop*>> footpaths_;
+};
+
+#endif
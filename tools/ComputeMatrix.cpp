@@ -0,0 +1,211 @@
+#include "Numa.hpp"
+#include "Parsing.hpp"
+#include "Raptor.hpp"
+#include "TravelTimeMatrix.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// load the timetable for the searches, nullptr if it can't be read
+std::unique_ptr<Timetable> loadTimetable(const std::string& directory, std::optional<HugePages> hugePages) {
+    auto&& timetable = std::make_unique<Timetable>();
+    if (!timetable->readCSVData(false, directory)) return nullptr;
+    if (hugePages && !timetable->compact(*hugePages)) return nullptr;
+    timetable->createTransfers();
+    return timetable;
+}
+
+// numbers separated by commas, nullopt if one of them isn't a number
+std::optional<std::vector<size_t>> parseList(const std::string& list) {
+    std::vector<size_t> values;
+    std::istringstream in{list};
+    for (std::string value; std::getline(in, value, ',');) {
+        auto&& number = parseNumber<size_t>(value);
+        if (!number) return std::nullopt;
+        values.emplace_back(*number);
+    }
+    return values;
+}
+
+// "h", "h:mm" or "h:mm:ss" -> seconds, nullopt if it isn't a time
+std::optional<uint32_t> parseTime(std::string_view time) {
+    uint32_t seconds = 0;
+    for (uint32_t unit: {3600u, 60u, 1u}) {
+        auto&& colon = time.find(':');
+        auto&& value = parseNumber<uint32_t>(time.substr(0, colon));
+        if (!value) return std::nullopt;
+        seconds += *value * unit;
+        if (colon == std::string_view::npos) return seconds;
+        time.remove_prefix(colon + 1);
+    }
+    return std::nullopt;
+}
+
+}
+
+// computes the travel times between all stops for several departure times into a matrix (see TravelTimeMatrix),
+// the origins are split into shards computed by the threads, every finished shard is saved at once,
+// so a killed job (or a failed shard) is finished by running the same command again
+// usage: ComputeMatrix <matrix file> --times 7:00,8:00 [options]
+//   --data DIR: directory with the timetable (data by default)
+//   --times H:MM,...: departure times from the origins
+//   --threads N: number of threads computing the shards (1 by default)
+//   --max-trips N: use at most N trips (5 by default)
+//   --shard-size N: origins in a shard (256 by default)
+//   --process I/N: compute only the shards s with s % N == I, N processes can share one matrix
+//   --shards LIST: compute only the listed shards
+//   --redo: compute the shards again even if they are finished
+//   --huge-pages none|transparent|explicit: store the arrays of stops and routes in an arena backed by the pages
+//   --numa: load a copy of the timetable on every NUMA node and pin the threads to the nodes
+int main(int argc, char* argv[]) {
+    std::string_view usage = "usage: ComputeMatrix <matrix file> --times H:MM,... [--data DIR] [--threads N] "
+                             "[--max-trips N] [--shard-size N] [--process I/N] [--shards LIST] [--redo] "
+                             "[--huge-pages MODE] [--numa]\n";
+    if (argc < 2) {
+        std::cout << usage;
+        return 1;
+    }
+    std::string matrixFile = argv[1];
+    std::string directory = Timetable::DATA_DIRECTORY;
+    TravelTimeMatrix::Options options;
+    size_t threadCount = 1, process = 0, processCount = 1;
+    std::vector<size_t> selectedShards;
+    bool redo = false, numa = false;
+    std::optional<HugePages> hugePages;
+    for (int i = 2; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+        if (arg == "--data" && i + 1 < argc) directory = argv[++i];
+        else if (arg == "--times" && i + 1 < argc) {
+            std::istringstream times{argv[++i]};
+            for (std::string time; std::getline(times, time, ',');) {
+                auto&& seconds = parseTime(time);
+                if (!seconds) {
+                    std::cout << "Invalid time " << time << '\n' << usage;
+                    return 1;
+                }
+                options.departureTimes.emplace_back(*seconds);
+            }
+        }
+        else if ((arg == "--threads" || arg == "--max-trips" || arg == "--shard-size") && i + 1 < argc) {
+            auto&& value = parseNumber<uint32_t>(argv[++i]);
+            if (!value) {
+                std::cout << "Invalid number " << argv[i] << '\n' << usage;
+                return 1;
+            }
+            if (arg == "--threads") threadCount = std::max<size_t>(1, *value);
+            else if (arg == "--max-trips") options.maxTrips = *value;
+            else options.shardSize = *value;
+        }
+        else if (arg == "--process" && i + 1 < argc) {
+            std::string_view value = argv[++i];
+            auto&& slash = value.find('/');
+            auto&& index = parseNumber<size_t>(value.substr(0, slash));
+            auto&& count = slash == std::string_view::npos ? std::optional<size_t>{1}
+                                                           : parseNumber<size_t>(value.substr(slash + 1));
+            if (!index || !count) {
+                std::cout << "Invalid process " << value << '\n' << usage;
+                return 1;
+            }
+            process = *index;
+            processCount = std::max<size_t>(1, *count);
+        }
+        else if (arg == "--shards" && i + 1 < argc) {
+            auto&& shards = parseList(argv[++i]);
+            if (!shards) {
+                std::cout << "Invalid shards " << argv[i] << '\n' << usage;
+                return 1;
+            }
+            selectedShards = std::move(*shards);
+        }
+        else if (arg == "--redo") redo = true;
+        else if (arg == "--numa") numa = true;
+        else if (arg == "--huge-pages" && i + 1 < argc) {
+            hugePages = getHugePages(argv[++i]);
+            if (!hugePages) {
+                std::cout << "Unknown huge pages " << argv[i] << '\n';
+                return 1;
+            }
+        }
+    }
+    if (options.departureTimes.empty()) {
+        std::cout << "No departure times (--times)\n";
+        return 1;
+    }
+
+    std::cout << "Loading data...\n";
+    std::vector<std::unique_ptr<Timetable>> timetables;
+    std::optional<NumaTopology> topology;
+    if (numa) {
+        // every copy is loaded by a thread on its node, so its memory is local to the node
+        topology.emplace();
+        timetables.resize(topology->getNodeCount());
+        topology->runOnNodes([&](size_t node) { timetables[node] = loadTimetable(directory, hugePages); });
+    }
+    else timetables.emplace_back(loadTimetable(directory, hugePages));
+    if (std::ranges::any_of(timetables, [](auto&& timetable) { return !timetable; })) return 1;
+
+    TravelTimeMatrix matrix;
+    if (!matrix.open(matrixFile, *timetables[0], options)) return 1;
+
+    // shards of this process that aren't finished yet
+    auto&& finished = matrix.readCheckpoint();
+    std::vector<size_t> shards;
+    for (size_t shard = 0; shard < matrix.getShardCount(); ++shard) {
+        if (shard % processCount != process || (finished[shard] && !redo)) continue;
+        if (selectedShards.empty() || std::ranges::find(selectedShards, shard) != selectedShards.end()) {
+            shards.emplace_back(shard);
+        }
+    }
+    std::cout << matrix.getStopCount() << " stops, " << options.departureTimes.size() << " departure times, "
+              << matrix.getShardCount() << " shards (" << std::ranges::count(finished, true) << " finished), "
+              << "computing " << shards.size() << " of them\n";
+
+    std::atomic<size_t> nextShard{0};
+    std::atomic<bool> failed{false};
+    std::mutex outputMutex;
+    auto worker = [&](size_t thread) {
+        auto&& node = topology ? topology->getThreadNode(thread) : 0;
+        if (topology) topology->pinThread(node);
+        for (size_t i; (i = nextShard.fetch_add(1)) < shards.size();) {
+            auto&& start = std::chrono::steady_clock::now();
+            auto&& travelTimes = matrix.computeShard(*timetables[node], shards[i]);
+            if (!matrix.writeShard(shards[i], travelTimes)) failed = true;
+            std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+            std::lock_guard lock{outputMutex};
+            auto&& [first, last] = matrix.getShardRows(shards[i]);
+            std::cout << std::fixed << std::setprecision(1) << "shard " << shards[i] << " (origins " << first << '-'
+                      << std::min(last, matrix.getStopCount()) - 1 << ") in " << duration.count() << " s\n";
+        }
+    };
+
+    auto&& start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; ++i) threads.emplace_back(worker, i);
+    worker(0);
+    for (auto&& thread: threads) thread.join();
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    size_t origins = 0;
+    for (auto&& shard: shards) {
+        auto&& [first, last] = matrix.getShardRows(shard);
+        origins += std::min(last, matrix.getStopCount()) - std::min(first, matrix.getStopCount());
+    }
+    std::cout << std::fixed << std::setprecision(1) << "Computed " << shards.size() << " shards in "
+              << duration.count() << " s (" << static_cast<double>(origins * options.departureTimes.size()) /
+              std::max(duration.count(), 1e-9) << " searches/s)\n";
+    return failed ? 1 : 0;
+}
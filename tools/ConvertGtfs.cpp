@@ -0,0 +1,64 @@
+#include "GtfsConverter.hpp"
+#include "Parsing.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// converts a GTFS feed (e.g. the PID feed from https://pid.cz/o-systemu/opendata/) into the csv files of data/
+// usage: ConvertGtfs <GTFS directory> [output directory] [options]
+//   --date YYYYMMDD: keep only the trips running on the date (all trips by default)
+//   --route-types 0,1,3: GTFS route types to keep (tram, metro and bus by default)
+//   --regional: keep the regional routes too
+//   --keep-diacritics: keep the names as they are in the feed
+int main(int argc, char* argv[]) {
+    std::string_view usage = "usage: ConvertGtfs <GTFS directory> [output directory] [--date YYYYMMDD] "
+                             "[--route-types 0,1,3] [--regional] [--keep-diacritics]\n";
+    if (argc < 2) {
+        std::cout << usage;
+        return 1;
+    }
+    std::string gtfsDirectory = argv[1];
+    std::string outputDirectory = "data";
+
+    GtfsConverter::Options options;
+    for (int i = 2; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+        if (arg == "--date" && i + 1 < argc) {
+            auto&& date = parseNumber<uint32_t>(argv[++i]);
+            if (!date) {
+                std::cout << "Invalid date " << argv[i] << '\n' << usage;
+                return 1;
+            }
+            options.date = *date;
+        }
+        else if (arg == "--route-types" && i + 1 < argc) {
+            options.routeTypes.clear();
+            std::istringstream types{argv[++i]};
+            for (std::string type; std::getline(types, type, ',');) {
+                auto&& value = parseNumber<uint32_t>(type);
+                if (!value) {
+                    std::cout << "Invalid route type " << type << '\n' << usage;
+                    return 1;
+                }
+                options.routeTypes.emplace_back(*value);
+            }
+        }
+        else if (arg == "--regional") options.regional = true;
+        else if (arg == "--keep-diacritics") options.ascii = false;
+        else if (!arg.starts_with("--")) outputDirectory = arg;
+    }
+
+    auto&& start = std::chrono::steady_clock::now();
+    GtfsConverter converter{options};
+    if (!converter.convert(gtfsDirectory, outputDirectory)) return 1;
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+
+    std::cout << "Converted " << converter.getStopCount() << " stops, " << converter.getRouteCount() << " routes, "
+              << converter.getTripCount() << " trips and " << converter.getStopTimeCount() << " stop times in "
+              << duration.count() << " s";
+    if (converter.getSkippedTripCount() != 0) std::cout << " (" << converter.getSkippedTripCount() << " trips skipped)";
+    std::cout << '\n';
+}
@@ -0,0 +1,246 @@
+#include "Numa.hpp"
+#include "Parsing.hpp"
+#include "QueryLog.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+// number of the biggest slowdowns and the differences printed
+constexpr size_t PRINTED_QUERIES = 10;
+
+double toMicroseconds(uint64_t nanoseconds) {
+    return static_cast<double>(nanoseconds) / 1000;
+}
+
+// percentile of sorted values
+template<typename T>
+T getPercentile(const std::vector<T>& sorted, double percentile) {
+    if (sorted.empty()) return {};
+    auto&& index = static_cast<size_t>(percentile / 100 * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+void printLatencies(std::string_view name, std::vector<uint64_t> durations) {
+    std::ranges::sort(durations);
+    std::cout << std::left << std::setw(10) << name << std::right;
+    for (double percentile: {50.0, 90.0, 99.0, 100.0}) {
+        std::cout << std::setw(12) << toMicroseconds(getPercentile(durations, percentile));
+    }
+    std::cout << '\n';
+}
+
+void printQuery(size_t i, const QueryRecord& record) {
+    std::cout << "  #" << i << ' ' << record.startName << " -> " << record.endName << " at "
+              << record.startTime << " (" << getEngineName(record.engine) << ")";
+}
+
+// load the timetable with everything the engines of the log need, nullptr if it can't be read
+std::unique_ptr<Timetable> loadTimetable(const std::string& directory, const std::vector<QueryRecord>& log,
+                                         std::optional<HugePages> hugePages) {
+    auto&& timetable = std::make_unique<Timetable>();
+    if (!timetable->readCSVData(false, directory)) return nullptr;
+    if (hugePages && !timetable->compact(*hugePages)) return nullptr;
+    timetable->createTransfers();
+    timetable->createStopGrid();
+    auto usesEngine = [&](EngineType type) {
+        return std::ranges::any_of(log, [type](auto&& record) { return record.engine == type; });
+    };
+    if (usesEngine(EngineType::ConnectionScan)) timetable->createConnections();
+    if (usesEngine(EngineType::TripBased) && !timetable->loadTripTransfers()) {
+        std::cout << "Computing trip transfers...\n";
+        timetable->computeTripTransfers();
+        if (!timetable->saveTripTransfers()) std::cout << "Can't save trip transfers\n";
+    }
+    return timetable;
+}
+
+// run the queries of the log, every thread takes the next query when it finishes one,
+// with a topology the threads are pinned to the nodes and use the timetable of their node
+std::vector<QueryRecord> replay(const std::vector<std::unique_ptr<Timetable>>& timetables,
+                                const NumaTopology* topology, const std::vector<QueryRecord>& log,
+                                size_t threadCount, size_t repetitions) {
+    std::vector<QueryRecord> results = log;
+    std::atomic<size_t> nextQuery{0};
+
+    auto worker = [&](size_t thread) {
+        auto&& node = topology ? topology->getThreadNode(thread) : 0;
+        if (topology) topology->pinThread(node);
+        auto&& timetable = *timetables[node];
+        for (size_t i; (i = nextQuery.fetch_add(1)) < results.size();) {
+            auto&& record = results[i];
+            auto&& query = timetable.createQuery(record.startName, record.endName, record.startTime);
+            query.maxTrips = record.maxTrips;
+            query.limits.maxWork = record.maxWork;
+
+            // the fastest of the repetitions, the deadlines aren't replayed (the results would depend on the machine)
+            auto&& fastest = std::chrono::nanoseconds::max();
+            for (size_t r = 0; r < repetitions; ++r) {
+                auto&& engine = createEngine(record.engine, timetable, query);
+                auto&& start = std::chrono::steady_clock::now();
+                engine->search();
+                fastest = std::min<std::chrono::nanoseconds>(fastest, std::chrono::steady_clock::now() - start);
+                if (r + 1 == repetitions) record.setResult(engine->getJourney(), fastest);
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < threadCount; ++i) threads.emplace_back(worker, i);
+    worker(0);
+    for (auto&& thread: threads) thread.join();
+    return results;
+}
+
+}
+
+// replays a query log (JourneyPlanner --log) on a timetable and compares the latencies and the results
+// with the log itself or with the results of another build (saved by --output)
+// usage: ReplayLog <query log> [options]
+//   --data DIR: directory with the timetable (data by default)
+//   --threads N: number of threads running the queries (1 by default)
+//   --repeat N: run every query N times and take the fastest run
+//   --engine raptor|trip-based|csa: run all queries with the engine instead of the logged one
+//   --output FILE: save the results as a query log, to be compared with another build
+//   --compare FILE: compare with the saved results instead of the log
+//   --huge-pages none|transparent|explicit: store the arrays of stops and routes in an arena backed by the pages
+//   --numa: load a copy of the timetable on every NUMA node and pin the threads to the nodes
+int main(int argc, char* argv[]) {
+    std::string_view usage = "usage: ReplayLog <query log> [--data DIR] [--threads N] [--repeat N] [--engine NAME] "
+                             "[--output FILE] [--compare FILE] [--huge-pages MODE] [--numa]\n";
+    if (argc < 2) {
+        std::cout << usage;
+        return 1;
+    }
+    std::string logFile = argv[1];
+    std::string directory = Timetable::DATA_DIRECTORY;
+    std::string outputFile, compareFile;
+    size_t threadCount = 1, repetitions = 1;
+    std::optional<EngineType> engine;
+    std::optional<HugePages> hugePages;
+    bool numa = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string_view arg{argv[i]};
+        if (arg == "--data" && i + 1 < argc) directory = argv[++i];
+        else if ((arg == "--threads" || arg == "--repeat") && i + 1 < argc) {
+            auto&& value = parseNumber<size_t>(argv[++i]);
+            if (!value) {
+                std::cout << "Invalid number " << argv[i] << '\n' << usage;
+                return 1;
+            }
+            (arg == "--threads" ? threadCount : repetitions) = std::max<size_t>(1, *value);
+        }
+        else if (arg == "--output" && i + 1 < argc) outputFile = argv[++i];
+        else if (arg == "--compare" && i + 1 < argc) compareFile = argv[++i];
+        else if (arg == "--numa") numa = true;
+        else if (arg == "--huge-pages" && i + 1 < argc) {
+            hugePages = getHugePages(argv[++i]);
+            if (!hugePages) {
+                std::cout << "Unknown huge pages " << argv[i] << '\n';
+                return 1;
+            }
+        }
+        else if (arg == "--engine" && i + 1 < argc) {
+            engine = getEngineType(argv[++i]);
+            if (!engine) {
+                std::cout << "Unknown engine " << argv[i] << '\n';
+                return 1;
+            }
+        }
+    }
+
+    std::vector<QueryRecord> log, baseline;
+    if (!QueryLog::read(logFile, log)) return 1;
+    if (engine) for (auto&& record: log) record.engine = *engine;
+    if (!compareFile.empty() && !QueryLog::read(compareFile, baseline)) return 1;
+    if (compareFile.empty()) baseline = log;
+    if (baseline.size() != log.size()) {
+        std::cout << "The compared results have " << baseline.size() << " queries, the log has " << log.size() << '\n';
+        return 1;
+    }
+
+    std::cout << "Loading data...\n";
+    std::vector<std::unique_ptr<Timetable>> timetables;
+    std::optional<NumaTopology> topology;
+    if (numa) {
+        // every copy is loaded by a thread on its node, so its memory is local to the node
+        topology.emplace();
+        timetables.resize(topology->getNodeCount());
+        topology->runOnNodes([&](size_t node) { timetables[node] = loadTimetable(directory, log, hugePages); });
+        std::cout << "Loaded " << timetables.size() << " copies of the timetable (one per NUMA node)\n";
+    }
+    else timetables.emplace_back(loadTimetable(directory, log, hugePages));
+    if (std::ranges::any_of(timetables, [](auto&& timetable) { return !timetable; })) return 1;
+
+    auto&& start = std::chrono::steady_clock::now();
+    auto&& results = replay(timetables, topology ? &*topology : nullptr, log, threadCount, repetitions);
+    std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+    std::cout << std::fixed << std::setprecision(1) << "Replayed " << log.size() << " queries with " << threadCount
+              << " threads in " << duration.count() << " s ("
+              << static_cast<double>(log.size() * repetitions) / duration.count() << " queries/s)\n";
+    if (!outputFile.empty() && !QueryLog::save(outputFile, results)) return 1;
+
+    // latencies of the baseline and of this run and the per query differences
+    auto getDurations = [](auto&& records) {
+        std::vector<uint64_t> durations;
+        for (auto&& record: records) durations.emplace_back(record.duration);
+        return durations;
+    };
+    std::cout << "latency us       p50         p90         p99         max\n";
+    printLatencies("baseline", getDurations(baseline));
+    printLatencies("replay", getDurations(results));
+
+    // latency differences of single queries
+    auto getDelta = [&](size_t i) {
+        return static_cast<int64_t>(results[i].duration) - static_cast<int64_t>(baseline[i].duration);
+    };
+    std::vector<int64_t> deltas;
+    for (size_t i = 0; i < log.size(); ++i) deltas.emplace_back(getDelta(i));
+    std::ranges::sort(deltas);
+    std::cout << "replay - baseline per query (us): p10 " << static_cast<double>(getPercentile(deltas, 10)) / 1000
+              << ", p50 " << static_cast<double>(getPercentile(deltas, 50)) / 1000
+              << ", p90 " << static_cast<double>(getPercentile(deltas, 90)) / 1000 << '\n';
+
+    std::vector<size_t> order(log.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::ranges::sort(order, std::greater{}, getDelta);
+    std::cout << "biggest slowdowns:\n";
+    for (size_t j = 0; j < std::min(PRINTED_QUERIES, order.size()) && getDelta(order[j]) > 0; ++j) {
+        auto&& i = order[j];
+        printQuery(i, log[i]);
+        std::cout << ' ' << toMicroseconds(baseline[i].duration) << " -> " << toMicroseconds(results[i].duration) << " us\n";
+    }
+
+    // different results, the searches stopped by their limits may differ
+    size_t different = 0, interrupted = 0;
+    for (size_t i = 0; i < log.size(); ++i) {
+        auto&& [expected, result] = std::tie(baseline[i], results[i]);
+        if (expected.arrivalTime == result.arrivalTime && expected.trips == result.trips) continue;
+        if (!expected.complete || !result.complete) {
+            ++interrupted;
+            continue;
+        }
+        if (different++ == 0) std::cout << "different results (arrival, trips):\n";
+        if (different > PRINTED_QUERIES) continue;
+        printQuery(i, log[i]);
+        std::cout << ' ' << expected.arrivalTime << ", " << +expected.trips << " -> " << result.arrivalTime << ", "
+                  << +result.trips << '\n';
+    }
+    std::cout << "different results " << different;
+    if (interrupted != 0) std::cout << " (and " << interrupted << " of searches stopped by their limits)";
+    std::cout << '\n';
+    return different != 0 ? 2 : 0;
+}